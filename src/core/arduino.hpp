@@ -5,6 +5,7 @@
 #ifdef ENV_NATIVE
 #include "test/FakeStream.hpp"
 #include "test/FakePgm.hpp"
+#include "test/FakeTime.hpp"
 #endif
 
 // TODO maybe there are cases where we don't want to include Arduino.h even if it exists in path
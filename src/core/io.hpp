@@ -5,6 +5,7 @@
 #include <stdint.h>
 
 #include "core/util.hpp"
+#include "io/layout.hpp"
 
 #ifdef __AVR_ARCH__
 #include "io/avr.hpp"
@@ -40,6 +41,7 @@ struct RightShift : PORT {
   static_assert(BITS <= util::countr_zero(PORT::MASK), "RightShift would underflow masked bits");
   using TYPE = typename PORT::TYPE;
   static const TYPE MASK = PORT::MASK >> BITS;
+  using LAYOUT = typename layout_shift<layout_of<PORT>, BITS>::type;
   static inline void bitwise_xor(TYPE value) { PORT::bitwise_xor(value << BITS); }
   static inline void bitwise_or(TYPE value) { PORT::bitwise_or(value << BITS); }
   static inline void bitwise_and(TYPE value) { PORT::bitwise_and(value << BITS); }
@@ -52,6 +54,7 @@ struct LeftShift : PORT {
   static_assert(BITS <= util::countl_zero(PORT::MASK), "LeftShift would overflow masked bits");
   using TYPE = typename PORT::TYPE;
   static const TYPE MASK = PORT::MASK << BITS;
+  using LAYOUT = typename layout_shift<layout_of<PORT>, -BITS>::type;
   static inline void bitwise_xor(TYPE value) { PORT::bitwise_xor(value >> BITS); }
   static inline void bitwise_or(TYPE value) { PORT::bitwise_or(value >> BITS); }
   static inline void bitwise_and(TYPE value) { PORT::bitwise_and(value >> BITS); }
@@ -62,6 +65,9 @@ struct LeftShift : PORT {
 template <typename PORT>
 using RightAlign = RightShift<PORT, util::countr_zero(PORT::MASK)>;
 
+// Join ports with non-overlapping masks as one port
+// Components that share a physical register are accessed together, so each
+// register costs one access (e.g. one read-modify-write) per operation
 template <typename Port1, typename Port2>
 struct Overlay {
   static_assert(util::is_same<typename Port1::TYPE, typename Port2::TYPE>::value,
@@ -70,83 +76,69 @@ struct Overlay {
     "Overlain ports must have non-overlapping masks");
   using TYPE = typename Port1::TYPE;
   static const TYPE MASK = Port1::MASK | Port2::MASK;
+  using LAYOUT = typename layout_concat<layout_of<Port1>, layout_of<Port2>>::type;
+  using OPS = LayoutOps<TYPE, LAYOUT>;
 
   // XOR value to both ports
-  static inline void bitwise_xor(TYPE value) {
-    Port1::bitwise_xor(value);
-    Port2::bitwise_xor(value);
-  }
+  static inline void bitwise_xor(TYPE value) { OPS::bitwise_xor(value); }
 
   // OR value to both ports
-  static inline void bitwise_or(TYPE value) {
-    Port1::bitwise_or(value);
-    Port2::bitwise_or(value);
-  }
+  static inline void bitwise_or(TYPE value) { OPS::bitwise_or(value); }
 
   // AND value to both ports
-  static inline void bitwise_and(TYPE value) {
-    Port1::bitwise_and(value);
-    Port2::bitwise_and(value);
-  }
+  static inline void bitwise_and(TYPE value) { OPS::bitwise_and(value); }
 
   // Write value to both ports
-  static inline void write(TYPE value) {
-    Port1::write(value);
-    Port2::write(value);
-  }
+  static inline void write(TYPE value) { OPS::write(value); }
 
   // Set bits in both ports
-  static inline void set() {
-    Port1::set();
-    Port2::set();
-  }
+  static inline void set() { OPS::set(); }
 
   // Clear bits in both ports
-  static inline void clear() {
-    Port1::clear();
-    Port2::clear();
-  }
+  static inline void clear() { OPS::clear(); }
 
   // Flip bits in both ports
-  static inline void flip() {
-    Port1::flip();
-    Port2::flip();
-  }
+  static inline void flip() { OPS::flip(); }
 
   // Read value from both ports
-  static inline TYPE read() {
-    return Port1::read() | Port2::read();
-  }
+  static inline TYPE read() { return OPS::read(); }
 
   // Return true if both ports are set
-  static inline bool is_set() {
-    return Port1::is_set() && Port2::is_set();
-  }
+  static inline bool is_set() { return OPS::is_set(); }
 
   // Return true if both ports are clear
-  static inline bool is_clear() {
-    return Port1::is_clear() && Port2::is_clear();
-  }
+  static inline bool is_clear() { return OPS::is_clear(); }
 
   // Select write mode for both ports
-  static inline void config_output() {
-    Port1::config_output();
-    Port2::config_output();
-  }
+  static inline void config_output() { OPS::config_output(); }
 
   // Select read mode for both ports
-  static inline void config_input() {
-    Port1::config_input();
-    Port2::config_input();
-  }
+  static inline void config_input() { OPS::config_input(); }
 
   // Select read mode with pullups on both ports
-  static inline void config_input_pullups() {
-    Port1::config_input_pullups();
-    Port2::config_input_pullups();
-  }
+  static inline void config_input_pullups() { OPS::config_input_pullups(); }
 };
 
+// Fallback for ports without write_changed; skip write if value is unchanged
+template <typename PORT>
+void write_changed_impl(long, typename PORT::TYPE prev, typename PORT::TYPE value) {
+  if (prev != value) {
+    PORT::write(value);
+  }
+}
+
+template <typename PORT>
+auto write_changed_impl(int, typename PORT::TYPE prev, typename PORT::TYPE value)
+    -> decltype(PORT::write_changed(prev, value)) {
+  PORT::write_changed(prev, value);
+}
+
+// Write value to port that currently holds prev, skipping unchanged subports
+template <typename PORT>
+void write_changed(typename PORT::TYPE prev, typename PORT::TYPE value) {
+  write_changed_impl<PORT>(0, prev, value);
+}
+
 template <typename ...>
 struct WordExtend {};
 
@@ -165,6 +157,7 @@ struct WordExtend<Port3, Port2, Port1, Port0> :
   WordExtend<WordExtend<Port3, Port2>, WordExtend<Port1, Port0>> {};
 
 // Join two ports as one port with double the word size
+// Halves that share a physical register (see LAYOUT) are accessed together
 template <typename PortMSB, typename PortLSB>
 struct WordExtend<PortMSB, PortLSB> {
   static_assert(util::is_same<typename PortLSB::TYPE, typename PortMSB::TYPE>::value,
@@ -172,81 +165,51 @@ struct WordExtend<PortMSB, PortLSB> {
   using TYPE = typename util::extend_unsigned<typename PortLSB::TYPE>::type;
   static constexpr uint8_t SHIFT = sizeof(typename PortLSB::TYPE) * 8;
   static const TYPE MASK = PortLSB::MASK | (TYPE(PortMSB::MASK) << SHIFT);
+  using LAYOUT = typename layout_concat<layout_of<PortLSB>,
+    typename layout_shift<layout_of<PortMSB>, -SHIFT>::type>::type;
+  using OPS = LayoutOps<TYPE, LAYOUT>;
 
   // XOR extended value to high and low ports
-  static inline void bitwise_xor(TYPE value) {
-    PortMSB::bitwise_xor(value >> SHIFT);
-    PortLSB::bitwise_xor(value);
-  }
+  static inline void bitwise_xor(TYPE value) { OPS::bitwise_xor(value); }
 
   // OR extended value to high and low ports
-  static inline void bitwise_or(TYPE value) {
-    PortMSB::bitwise_or(value >> SHIFT);
-    PortLSB::bitwise_or(value);
-  }
+  static inline void bitwise_or(TYPE value) { OPS::bitwise_or(value); }
 
   // AND extended value to high and low ports
-  static inline void bitwise_and(TYPE value) {
-    PortMSB::bitwise_and(value >> SHIFT);
-    PortLSB::bitwise_and(value);
-  }
+  static inline void bitwise_and(TYPE value) { OPS::bitwise_and(value); }
 
   // Write extended value to high and low ports
-  static inline void write(TYPE value) {
-    PortMSB::write(value >> SHIFT);
-    PortLSB::write(value);
-  }
+  static inline void write(TYPE value) { OPS::write(value); }
+
+  // Write extended value, skipping registers whose bits match prev
+  static inline void write_changed(TYPE prev, TYPE value) { OPS::write_changed(prev, value); }
 
   // Set bits in both ports
-  static inline void set() {
-    PortMSB::set();
-    PortLSB::set();
-  }
+  static inline void set() { OPS::set(); }
 
   // Clear bits in both ports
-  static inline void clear() {
-    PortMSB::clear();
-    PortLSB::clear();
-  }
+  static inline void clear() { OPS::clear(); }
 
   // Flip bits in both ports
-  static inline void flip() {
-    PortMSB::flip();
-    PortLSB::flip();
-  }
+  static inline void flip() { OPS::flip(); }
 
   // Read extended value from high and low ports
-  static inline TYPE read() {
-    return TYPE(PortLSB::read()) | (TYPE(PortMSB::read()) << SHIFT);
-  }
+  static inline TYPE read() { return OPS::read(); }
 
   // Return true if both ports are set
-  static inline bool is_set() {
-    return PortLSB::is_set() && PortMSB::is_set();
-  }
+  static inline bool is_set() { return OPS::is_set(); }
 
   // Return true if both ports are clear
-  static inline bool is_clear() {
-    return PortLSB::is_clear() && PortMSB::is_clear();
-  }
+  static inline bool is_clear() { return OPS::is_clear(); }
 
   // Select write mode for both ports
-  static inline void config_output() {
-    PortMSB::config_output();
-    PortLSB::config_output();
-  }
+  static inline void config_output() { OPS::config_output(); }
 
   // Select read mode for both ports
-  static inline void config_input() {
-    PortMSB::config_input();
-    PortLSB::config_input();
-  }
+  static inline void config_input() { OPS::config_input(); }
 
   // Select read mode with pullups for both ports
-  static inline void config_input_pullups() {
-    PortMSB::config_input_pullups();
-    PortLSB::config_input_pullups();
-  }
+  static inline void config_input_pullups() { OPS::config_input_pullups(); }
 };
 
 template <typename ...>
@@ -261,5 +224,82 @@ struct BitExtend<PORT_MSB, PORT_LSB> : Overlay<
 template <typename MSB, typename... LSB>
 struct BitExtend<MSB, LSB...> : BitExtend<MSB, BitExtend<LSB...>> {};
 
+// Move value bit i to bit MAP[i] for each entry in MAP
+constexpr uint8_t permute_bits(uint8_t, uint8_t) { return 0; }
+
+template <typename... MAP>
+constexpr uint8_t permute_bits(uint8_t value, uint8_t i, uint8_t bit, MAP... map) {
+  return ((value >> i) & 1 ? uint8_t(1 << bit) : 0) | permute_bits(value, i + 1, map...);
+}
+
+// Move bit MAP[i] to value bit i for each entry in MAP
+constexpr uint8_t unpermute_bits(uint8_t, uint8_t) { return 0; }
+
+template <typename... MAP>
+constexpr uint8_t unpermute_bits(uint8_t value, uint8_t i, uint8_t bit, MAP... map) {
+  return ((value >> bit) & 1 ? uint8_t(1 << i) : 0) | unpermute_bits(value, i + 1, map...);
+}
+
+// Count set bits
+constexpr uint8_t popcount(uint8_t value) {
+  return value == 0 ? 0 : (value & 1) + popcount(value >> 1);
+}
+
+// Lookup tables for every 8-bit value, generated at compile time
+template <typename SEQ, uint8_t... MAP>
+struct PermuteTable;
+
+template <uint16_t... I, uint8_t... MAP>
+struct PermuteTable<util::index_sequence<I...>, MAP...> {
+  static const uint8_t FORWARD[sizeof...(I)];
+  static const uint8_t INVERSE[sizeof...(I)];
+};
+
+template <uint16_t... I, uint8_t... MAP>
+const uint8_t PermuteTable<util::index_sequence<I...>, MAP...>::FORWARD[sizeof...(I)] PROGMEM = {
+  permute_bits(uint8_t(I), 0, MAP...)... };
+
+template <uint16_t... I, uint8_t... MAP>
+const uint8_t PermuteTable<util::index_sequence<I...>, MAP...>::INVERSE[sizeof...(I)] PROGMEM = {
+  unpermute_bits(uint8_t(I), 0, MAP...)... };
+
+// Reorder bits of 8-bit PORT, where value bit i is wired to PORT bit MAP[i]
+// Unmapped bits of PORT are left alone, using PORT::Mask if MAP has fewer bits
+// Each access is one table lookup (from PROGMEM on AVR) rather than a chain
+// of shifts, at the cost of 512 bytes of tables per distinct MAP
+template <typename PORT, uint8_t... MAP>
+struct PermutePort {
+  static_assert(sizeof(typename PORT::TYPE) == 1, "PermutePort requires an 8-bit port");
+  static_assert(sizeof...(MAP) > 0 && sizeof...(MAP) <= 8, "PermutePort maps 1 to 8 bits");
+  using TYPE = typename PORT::TYPE;
+  using TABLE = PermuteTable<util::make_index_sequence<256>, MAP...>;
+  static const TYPE MASK = (1 << sizeof...(MAP)) - 1;
+  // PORT bits selected by MAP
+  static const TYPE PORT_MASK = permute_bits(MASK, 0, MAP...);
+  static_assert(popcount(PORT_MASK) == sizeof...(MAP), "MAP must not repeat bits");
+  static_assert((PORT_MASK & ~PORT::MASK) == 0, "MAP must select bits within PORT::MASK");
+
+  // Only the mapped bits of PORT are written or configured
+  using REG = typename masked_reg<PORT, PORT_MASK>::type;
+
+  // Convert between value and PORT bit order
+  static inline TYPE to_port(TYPE value) { return pgm_read_byte(TABLE::FORWARD + value); }
+  static inline TYPE from_port(TYPE bits) { return pgm_read_byte(TABLE::INVERSE + bits); }
+
+  static inline void bitwise_xor(TYPE value) { REG::bitwise_xor(to_port(value)); }
+  static inline void bitwise_or(TYPE value) { REG::bitwise_or(to_port(value)); }
+  static inline void bitwise_and(TYPE value) { REG::bitwise_and(to_port(value) | TYPE(~PORT_MASK)); }
+  static inline void write(TYPE value) { REG::write(to_port(value)); }
+  static inline void set() { REG::set(); }
+  static inline void clear() { REG::clear(); }
+  static inline void flip() { REG::flip(); }
+  static inline TYPE read() { return from_port(REG::read() & PORT_MASK); }
+  static inline bool is_set() { return REG::is_set(); }
+  static inline bool is_clear() { return REG::is_clear(); }
+  static inline void config_output() { REG::config_output(); }
+  static inline void config_input() { REG::config_input(); }
+  static inline void config_input_pullups() { REG::config_input_pullups(); }
+};
+
 } // namespace io
 } // namespace core
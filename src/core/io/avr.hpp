@@ -6,6 +6,7 @@
 #include <avr/io.h>
 
 #include "core/util.hpp"
+#include "core/io/layout.hpp"
 
 #define CORE_REG(REG) \
   using TYPE_##REG = core::util::remove_volatile_reference<decltype((REG))>::type; \
@@ -127,6 +128,9 @@ struct Port : PORT::Output, PIN::Input {
     typename PORT::template Mask<MASK>,
     typename PIN::template Mask<MASK>>;
 
+  // Masked bits of the whole I/O port; lets Overlay merge accesses to it
+  using LAYOUT = Layout<Component<Mask<TYPE(~0)>, TYPE, MASK, 0>>;
+
   // Invert output bits
   static inline void flip() {
     PIN::set(); //< Set bits in PIN to flip bits in PORT
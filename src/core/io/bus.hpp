@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "core/io.hpp"
 #include "core/util.hpp"
 
 #include <stdint.h>
@@ -61,6 +62,103 @@ struct Latch {
   }
 };
 
+// Recursive helper for iterating over LatchBank enables
+template <typename... ENABLES>
+struct LatchEach {
+  static void config_output() {}
+  static void config_input() {}
+  template <typename DATA, typename TYPE>
+  static void commit(const TYPE*, TYPE*, TYPE&, bool&, bool) {}
+};
+
+template <typename ENABLE, typename... ENABLES>
+struct LatchEach<ENABLE, ENABLES...> {
+  static void config_output() {
+    ENABLE::config_output();
+    LatchEach<ENABLES...>::config_output();
+  }
+
+  static void config_input() {
+    ENABLE::config_input();
+    LatchEach<ENABLES...>::config_input();
+  }
+
+  // Drive latch if forced or if staged value differs from shadow
+  template <typename DATA, typename TYPE>
+  static void commit(const TYPE* staged, TYPE* shadow, TYPE& driven, bool& valid, bool force) {
+    if (force || *staged != *shadow) {
+      // DATA holds its value between latches; skip rewriting it if unchanged
+      if (!valid || *staged != driven) {
+        DATA::write(*staged);
+        driven = *staged;
+        valid = true;
+      }
+      ENABLE::enable();
+      ENABLE::disable();
+      *shadow = *staged;
+    }
+    LatchEach<ENABLES...>::template commit<DATA>(staged + 1, shadow + 1, driven, valid, force);
+  }
+};
+
+// Several latches sharing DATA, each with its own latch enable (e.g. 74HC573)
+// Changes are staged with set and applied by commit, which only pulses the
+// enables of latches whose value changed since the last commit
+// Call invalidate if anything else writes DATA between commits
+template <typename DATA, typename... ENABLES>
+struct LatchBank {
+  using TYPE = typename DATA::TYPE;
+  static const uint8_t COUNT = sizeof...(ENABLES);
+  static_assert(COUNT > 0, "LatchBank requires at least one latch");
+
+  static void config_output() {
+    DATA::config_output();
+    LatchEach<ENABLES...>::config_output();
+  }
+
+  static void config_input() {
+    LatchEach<ENABLES...>::config_input();
+  }
+
+  // Stage value for latch i, applied on next commit
+  static void set(uint8_t i, TYPE value) { staged_[i] = value; }
+
+  // Get staged value for latch i
+  static TYPE get(uint8_t i) { return staged_[i]; }
+
+  // Drive latches with staged values that differ from their last driven value
+  static void commit() {
+    LatchEach<ENABLES...>::template commit<DATA>(staged_, shadow_, driven_, valid_, false);
+  }
+
+  // Drive every latch with its staged value (e.g. after power-up)
+  static void refresh() {
+    valid_ = false;
+    LatchEach<ENABLES...>::template commit<DATA>(staged_, shadow_, driven_, valid_, true);
+  }
+
+  // Forget value left on DATA by the last commit
+  static void invalidate() { valid_ = false; }
+
+private:
+  static TYPE staged_[sizeof...(ENABLES)];
+  static TYPE shadow_[sizeof...(ENABLES)];
+  static TYPE driven_;
+  static bool valid_;
+};
+
+template <typename DATA, typename... ENABLES>
+typename DATA::TYPE LatchBank<DATA, ENABLES...>::staged_[sizeof...(ENABLES)];
+
+template <typename DATA, typename... ENABLES>
+typename DATA::TYPE LatchBank<DATA, ENABLES...>::shadow_[sizeof...(ENABLES)];
+
+template <typename DATA, typename... ENABLES>
+typename DATA::TYPE LatchBank<DATA, ENABLES...>::driven_;
+
+template <typename DATA, typename... ENABLES>
+bool LatchBank<DATA, ENABLES...>::valid_ = false;
+
 // Derived types should define the following:
 // typename DATA_TYPE
 // typename ADDRESS_TYPE
@@ -69,17 +167,148 @@ struct Latch {
 // static void config_write()
 // static void config_read()
 // static void config_float()
+// Derived types can also define the following to transfer sequential blocks:
+// static void read_block(ADDRESS_TYPE addr, DATA_TYPE* buf, uint16_t n)
+// static void write_block(ADDRESS_TYPE addr, const DATA_TYPE* buf, uint16_t n)
+// Derived types that can detect failed writes can also define:
+// static bool write_failed() // true if a write failed since the last call
 struct BaseBus {
   // Derived types can override to flush delayed writes (e.g. EEPROM page mode)
   static void flush_write() {}
 };
 
+// Direction selected by the most recent config_write/read/float
+enum class BusMode : uint8_t {
+  UNKNOWN,
+  READ,
+  WRITE,
+  FLOAT,
+};
+
+// Fallback for buses without read_block; read one word at a time
+template <typename BUS>
+void read_block_impl(long, typename BUS::ADDRESS_TYPE addr, typename BUS::DATA_TYPE* buf, uint16_t n) {
+  for (uint16_t i = 0; i < n; ++i) {
+    buf[i] = BUS::read_bus(addr + i);
+  }
+}
+
+template <typename BUS>
+auto read_block_impl(int, typename BUS::ADDRESS_TYPE addr, typename BUS::DATA_TYPE* buf, uint16_t n)
+    -> decltype(BUS::read_block(addr, buf, n)) {
+  BUS::read_block(addr, buf, n);
+}
+
+// Fallback for buses without write_block; write one word at a time
+template <typename BUS>
+void write_block_impl(long, typename BUS::ADDRESS_TYPE addr, const typename BUS::DATA_TYPE* buf, uint16_t n) {
+  for (uint16_t i = 0; i < n; ++i) {
+    BUS::write_bus(addr + i, buf[i]);
+  }
+}
+
+template <typename BUS>
+auto write_block_impl(int, typename BUS::ADDRESS_TYPE addr, const typename BUS::DATA_TYPE* buf, uint16_t n)
+    -> decltype(BUS::write_block(addr, buf, n)) {
+  BUS::write_block(addr, buf, n);
+}
+
+// Buses whose block methods bypass read_bus/write_bus declare BLOCK_BUS as
+// themselves, so a derived bus that overrides read_bus/write_bus does not
+// inherit them; the derived bus may declare BLOCK_BUS again to opt back in
+template <typename BUS>
+auto has_block_impl(int) -> util::is_same<typename BUS::BLOCK_BUS, BUS>;
+
+template <typename BUS>
+auto has_block_impl(long) -> util::is_same<BUS, BUS>;
+
+// Select block methods of BUS (int) or word fallback (long)
+template <typename BUS>
+using block_tag = typename util::conditional<decltype(has_block_impl<BUS>(0))::value, int, long>::type;
+
+// Read n words from sequential addresses, using BUS::read_block if provided
+template <typename BUS>
+void read_block(typename BUS::ADDRESS_TYPE addr, typename BUS::DATA_TYPE* buf, uint16_t n) {
+  read_block_impl<BUS>(block_tag<BUS>(0), addr, buf, n);
+}
+
+// Write n words to sequential addresses, using BUS::write_block if provided
+template <typename BUS>
+void write_block(typename BUS::ADDRESS_TYPE addr, const typename BUS::DATA_TYPE* buf, uint16_t n) {
+  write_block_impl<BUS>(block_tag<BUS>(0), addr, buf, n);
+}
+
+// Fallback for buses that cannot detect failed writes
+template <typename BUS>
+bool write_failed_impl(long) { return false; }
+
+template <typename BUS>
+auto write_failed_impl(int) -> decltype(BUS::write_failed()) {
+  return BUS::write_failed();
+}
+
+// Return true if BUS reports a failed write since the last call
+// Check after flush_write, as writes may be delayed until then
+template <typename BUS>
+bool write_failed() {
+  return write_failed_impl<BUS>(0);
+}
+
+// Fallback for buses that don't count skipped writes
+template <typename BUS>
+void reset_write_stats_impl(long) {}
+
+template <typename BUS>
+auto reset_write_stats_impl(int) -> decltype(BUS::skipped(), BUS::reset()) {
+  BUS::reset();
+}
+
+// Zero written/skipped counts, if BUS keeps them (see DiffWriteBus), at the
+// start of an operation
+template <typename BUS>
+void reset_write_stats() {
+  reset_write_stats_impl<BUS>(0);
+}
+
+// Collect sequential writes and pass them to the bus in blocks
+// Call flush before changing bus direction or when done writing
+template <typename BUS, uint8_t SIZE = 16>
+class BlockWriter {
+  using ADDRESS_TYPE = typename BUS::ADDRESS_TYPE;
+  using DATA_TYPE = typename BUS::DATA_TYPE;
+
+  ADDRESS_TYPE start_ = 0;
+  uint8_t count_ = 0;
+  DATA_TYPE buffer_[SIZE];
+
+public:
+  void write(ADDRESS_TYPE addr, DATA_TYPE data) {
+    // Flush if full or if addr does not follow the buffered block
+    if (count_ == SIZE || (count_ > 0 && addr != ADDRESS_TYPE(start_ + count_))) {
+      flush();
+    }
+    if (count_ == 0) {
+      start_ = addr;
+    }
+    buffer_[count_++] = data;
+  }
+
+  void flush() {
+    if (count_ > 0) {
+      write_block<BUS>(start_, buffer_, count_);
+      count_ = 0;
+    }
+  }
+};
+
 // Parallel computer bus for interfacing with external devices
 // See read_bus comments on overriding if necessary
 template <typename ADDRESS, typename DATA, typename RE, typename WE>
 struct PortBus : BaseBus {
   using ADDRESS_TYPE = typename ADDRESS::TYPE;
   using DATA_TYPE = typename DATA::TYPE;
+  // Block methods don't call read_bus/write_bus (see io::read_block)
+  using BLOCK_BUS = PortBus;
 
   static void config_write() {
     ADDRESS::config_output();
@@ -103,7 +332,7 @@ struct PortBus : BaseBus {
   }
 
   static void write_bus(ADDRESS_TYPE addr, DATA_TYPE data) {
-    ADDRESS::write(addr);
+    seek(addr);
     WE::enable();
     DATA::write(data);
     WE::disable();
@@ -114,7 +343,7 @@ struct PortBus : BaseBus {
   // - tOE longer than 70ns results in corrupted read value
   static DATA_TYPE read_bus(ADDRESS_TYPE addr) {
     //DATA::config_output();
-    ADDRESS::write(addr);
+    seek(addr);
     //DATA::config_input();
     RE::enable();
     // Need at least one cycle delay for AVR read latency
@@ -124,8 +353,756 @@ struct PortBus : BaseBus {
     RE::disable();
     return data;
   }
+
+  // Output address for following read_next/write_next
+  // NOTE must be called again after config_float, which clears ADDRESS
+  static void seek(ADDRESS_TYPE addr) {
+    ADDRESS::write(addr);
+    addr_ = addr;
+  }
+
+  // Write at current address and advance to the next
+  static void write_next(DATA_TYPE data) {
+    WE::enable();
+    DATA::write(data);
+    WE::disable();
+    advance();
+  }
+
+  // Read from current address and advance to the next
+  static DATA_TYPE read_next() {
+    RE::enable();
+    util::nop<2>(); // same tOE margin as read_bus
+    const DATA_TYPE data = DATA::read();
+    RE::disable();
+    advance();
+    return data;
+  }
+
+  // Write sequential block, strobing WE back to back without reconfiguring DATA
+  static void write_block(ADDRESS_TYPE addr, const DATA_TYPE* buf, uint16_t n) {
+    seek(addr);
+    for (uint16_t i = 0; i < n; ++i) {
+      write_next(buf[i]);
+    }
+  }
+
+  // Read sequential block, strobing RE back to back without reconfiguring DATA
+  // Not used by io::read_block for derived buses unless they declare BLOCK_BUS
+  static void read_block(ADDRESS_TYPE addr, DATA_TYPE* buf, uint16_t n) {
+    seek(addr);
+    for (uint16_t i = 0; i < n; ++i) {
+      buf[i] = read_next();
+    }
+  }
+
+private:
+  // Increment address, only writing ports with changed bits (e.g. MSB on carry)
+  static void advance() {
+    const ADDRESS_TYPE next = addr_ + 1;
+    write_changed<ADDRESS>(addr_, next);
+    addr_ = next;
+  }
+
+  static ADDRESS_TYPE addr_;
+};
+
+template <typename ADDRESS, typename DATA, typename RE, typename WE>
+typename ADDRESS::TYPE PortBus<ADDRESS, DATA, RE, WE>::addr_;
+
+// Multiplexed bus where DATA also drives the address through external latches
+// LSB_LATCH and MSB_LATCH are Latch<DATA, ...> types holding each address byte
+// The last latched MSB is remembered, so accesses within the same 256-word
+// page only latch the LSB; call invalidate if anything else drives MSB_LATCH
+template <typename DATA, typename LSB_LATCH, typename MSB_LATCH, typename RE, typename WE>
+struct MuxBus : BaseBus {
+  using DATA_TYPE = typename DATA::TYPE;
+  using ADDRESS_TYPE = typename util::extend_unsigned<DATA_TYPE>::type;
+  static const uint8_t BITS = sizeof(DATA_TYPE) * 8;
+
+  static void config_write() {
+    LSB_LATCH::config_output();
+    MSB_LATCH::config_output();
+    DATA::config_output();
+    RE::config_output();
+    WE::config_output();
+  }
+
+  static void config_read() {
+    LSB_LATCH::config_output();
+    MSB_LATCH::config_output();
+    DATA::config_input();
+    RE::config_output();
+    WE::config_output();
+  }
+
+  static void config_float() {
+    LSB_LATCH::config_input();
+    MSB_LATCH::config_input();
+    DATA::config_input();
+    RE::config_input();
+    WE::config_input();
+    invalidate();
+  }
+
+  static void write_bus(ADDRESS_TYPE addr, DATA_TYPE data) {
+    latch(addr);
+    WE::enable();
+    DATA::write(data);
+    WE::disable();
+  }
+
+  static DATA_TYPE read_bus(ADDRESS_TYPE addr) {
+    // DATA must be turned around to drive the latches
+    DATA::config_output();
+    latch(addr);
+    DATA::config_input();
+    RE::enable();
+    util::nop<2>(); // same tOE margin as PortBus
+    const DATA_TYPE data = DATA::read();
+    RE::disable();
+    return data;
+  }
+
+  // Force the next access to latch the MSB
+  static void invalidate() { msb_valid_ = false; }
+
+private:
+  static void latch(ADDRESS_TYPE addr) {
+    const DATA_TYPE msb = DATA_TYPE(addr >> BITS);
+    if (!msb_valid_ || msb != msb_) {
+      MSB_LATCH::write(msb);
+      msb_ = msb;
+      msb_valid_ = true;
+    }
+    LSB_LATCH::write(DATA_TYPE(addr));
+  }
+
+  static DATA_TYPE msb_;
+  static bool msb_valid_;
+};
+
+template <typename DATA, typename LSB_LATCH, typename MSB_LATCH, typename RE, typename WE>
+typename DATA::TYPE MuxBus<DATA, LSB_LATCH, MSB_LATCH, RE, WE>::msb_;
+
+template <typename DATA, typename LSB_LATCH, typename MSB_LATCH, typename RE, typename WE>
+bool MuxBus<DATA, LSB_LATCH, MSB_LATCH, RE, WE>::msb_valid_ = false;
+
+// Map a wide address space onto BUS through a window of 2^WINDOW_BITS words
+// Upper address bits select the bank written to BANK, which is only rewritten
+// when the bank changes; call invalidate if anything else writes BANK
+template <typename BUS, typename BANK, uint8_t WINDOW_BITS, typename ADDRESS = uint32_t>
+struct BankedBus : BaseBus {
+  using ADDRESS_TYPE = ADDRESS;
+  using DATA_TYPE = typename BUS::DATA_TYPE;
+  using BANK_TYPE = typename BANK::TYPE;
+  using OFFSET_TYPE = typename BUS::ADDRESS_TYPE;
+  static_assert(WINDOW_BITS < sizeof(ADDRESS) * 8, "WINDOW_BITS must be narrower than ADDRESS");
+  static const ADDRESS WINDOW_SIZE = ADDRESS(1) << WINDOW_BITS;
+
+  static void config_write() {
+    BANK::config_output();
+    BUS::config_write();
+  }
+
+  static void config_read() {
+    BANK::config_output();
+    BUS::config_read();
+  }
+
+  static void config_float() {
+    BANK::config_input();
+    BUS::config_float();
+    invalidate();
+  }
+
+  static void flush_write() { BUS::flush_write(); }
+  static bool write_failed() { return io::write_failed<BUS>(); }
+
+  static DATA_TYPE read_bus(ADDRESS_TYPE addr) {
+    return BUS::read_bus(select(addr));
+  }
+
+  static void write_bus(ADDRESS_TYPE addr, DATA_TYPE data) {
+    BUS::write_bus(select(addr), data);
+  }
+
+  // Split blocks where they cross into the next bank
+  static void read_block(ADDRESS_TYPE addr, DATA_TYPE* buf, uint16_t n) {
+    while (n > 0) {
+      const uint16_t run = window_run(addr, n);
+      io::read_block<BUS>(select(addr), buf, run);
+      addr += run;
+      buf += run;
+      n -= run;
+    }
+  }
+
+  static void write_block(ADDRESS_TYPE addr, const DATA_TYPE* buf, uint16_t n) {
+    while (n > 0) {
+      const uint16_t run = window_run(addr, n);
+      io::write_block<BUS>(select(addr), buf, run);
+      addr += run;
+      buf += run;
+      n -= run;
+    }
+  }
+
+  // Force the next access to write BANK
+  static void invalidate() { bank_valid_ = false; }
+
+private:
+  // Write BANK if changed and return offset within window
+  static OFFSET_TYPE select(ADDRESS_TYPE addr) {
+    const BANK_TYPE bank = BANK_TYPE(addr >> WINDOW_BITS);
+    if (!bank_valid_ || bank != bank_) {
+      BANK::write(bank);
+      bank_ = bank;
+      bank_valid_ = true;
+    }
+    return OFFSET_TYPE(addr & (WINDOW_SIZE - 1));
+  }
+
+  // Words from addr to end of window, up to n
+  static uint16_t window_run(ADDRESS_TYPE addr, uint16_t n) {
+    const ADDRESS_TYPE left = WINDOW_SIZE - (addr & (WINDOW_SIZE - 1));
+    return left < n ? uint16_t(left) : n;
+  }
+
+  static BANK_TYPE bank_;
+  static bool bank_valid_;
+};
+
+template <typename BUS, typename BANK, uint8_t WINDOW_BITS, typename ADDRESS>
+typename BANK::TYPE BankedBus<BUS, BANK, WINDOW_BITS, ADDRESS>::bank_;
+
+template <typename BUS, typename BANK, uint8_t WINDOW_BITS, typename ADDRESS>
+bool BankedBus<BUS, BANK, WINDOW_BITS, ADDRESS>::bank_valid_ = false;
+
+// Skip config_write/read/float when BUS is already in the requested mode
+// Call invalidate if anything else reconfigures the underlying ports
+template <typename BUS>
+struct CachedDirectionBus : BaseBus {
+  using ADDRESS_TYPE = typename BUS::ADDRESS_TYPE;
+  using DATA_TYPE = typename BUS::DATA_TYPE;
+
+  static void config_write() {
+    if (mode_ != BusMode::WRITE) {
+      mode_ = BusMode::WRITE;
+      BUS::config_write();
+    }
+  }
+
+  static void config_read() {
+    if (mode_ != BusMode::READ) {
+      mode_ = BusMode::READ;
+      BUS::config_read();
+    }
+  }
+
+  static void config_float() {
+    if (mode_ != BusMode::FLOAT) {
+      mode_ = BusMode::FLOAT;
+      BUS::config_float();
+    }
+  }
+
+  // Force the next config call through to BUS
+  static void invalidate() { mode_ = BusMode::UNKNOWN; }
+
+  static BusMode mode() { return mode_; }
+
+  static void flush_write() { BUS::flush_write(); }
+  static bool write_failed() { return io::write_failed<BUS>(); }
+  static DATA_TYPE read_bus(ADDRESS_TYPE addr) { return BUS::read_bus(addr); }
+  static void write_bus(ADDRESS_TYPE addr, DATA_TYPE data) { BUS::write_bus(addr, data); }
+  static void read_block(ADDRESS_TYPE addr, DATA_TYPE* buf, uint16_t n) { io::read_block<BUS>(addr, buf, n); }
+  static void write_block(ADDRESS_TYPE addr, const DATA_TYPE* buf, uint16_t n) { io::write_block<BUS>(addr, buf, n); }
+
+private:
+  static BusMode mode_;
+};
+
+template <typename BUS>
+BusMode CachedDirectionBus<BUS>::mode_ = BusMode::UNKNOWN;
+
+// Bus traffic counters collected by CountingBus
+struct BusCounts {
+  uint32_t reads;
+  uint32_t writes;
+  uint32_t config_reads;
+  uint32_t config_writes;
+  uint32_t config_floats;
+  uint32_t flushes;
+};
+
+// Count operations passed through to BUS for profiling
+// If BINS > 0, reads and writes are also counted by address range, with the
+// address space split into BINS equal bins
+template <typename BUS, uint8_t BINS = 0>
+struct CountingBus : BaseBus {
+  static_assert(BINS != 1 && (BINS == 0 || util::is_power_of_two(BINS)),
+    "BINS must be 0 or a power of two greater than 1");
+  using ADDRESS_TYPE = typename BUS::ADDRESS_TYPE;
+  using DATA_TYPE = typename BUS::DATA_TYPE;
+
+  static constexpr uint8_t BIN_COUNT = BINS;
+
+  // Bin index is taken from the address bits above BIN_SHIFT
+  static constexpr uint8_t BIN_SHIFT = sizeof(ADDRESS_TYPE) * 8 - (BINS > 0 ? util::ilog2(BINS) : 0);
+
+  static void config_write() {
+    ++counts_.config_writes;
+    BUS::config_write();
+  }
+
+  static void config_read() {
+    ++counts_.config_reads;
+    BUS::config_read();
+  }
+
+  static void config_float() {
+    ++counts_.config_floats;
+    BUS::config_float();
+  }
+
+  static void flush_write() {
+    ++counts_.flushes;
+    BUS::flush_write();
+  }
+
+  static bool write_failed() { return io::write_failed<BUS>(); }
+
+  static DATA_TYPE read_bus(ADDRESS_TYPE addr) {
+    ++counts_.reads;
+    count_bins(addr, 1);
+    return BUS::read_bus(addr);
+  }
+
+  static void write_bus(ADDRESS_TYPE addr, DATA_TYPE data) {
+    ++counts_.writes;
+    count_bins(addr, 1);
+    BUS::write_bus(addr, data);
+  }
+
+  static void read_block(ADDRESS_TYPE addr, DATA_TYPE* buf, uint16_t n) {
+    counts_.reads += n;
+    count_bins(addr, n);
+    io::read_block<BUS>(addr, buf, n);
+  }
+
+  static void write_block(ADDRESS_TYPE addr, const DATA_TYPE* buf, uint16_t n) {
+    counts_.writes += n;
+    count_bins(addr, n);
+    io::write_block<BUS>(addr, buf, n);
+  }
+
+  static const BusCounts& counts() { return counts_; }
+
+  // Return reads and writes within bin, where bin starts at address index << BIN_SHIFT
+  static uint32_t bin_count(uint8_t index) { return index < BINS ? bins_[index] : 0; }
+
+  static void reset() {
+    counts_ = BusCounts{};
+    for (uint32_t& count : bins_) {
+      count = 0;
+    }
+  }
+
+private:
+  static void count_bins(ADDRESS_TYPE addr, uint16_t n) {
+    if (BINS > 0) {
+      for (uint16_t i = 0; i < n; ++i) {
+        ++bins_[ADDRESS_TYPE(addr + i) >> BIN_SHIFT];
+      }
+    }
+  }
+
+  static BusCounts counts_;
+  static uint32_t bins_[BINS > 0 ? BINS : 1];
+};
+
+template <typename BUS, uint8_t BINS>
+BusCounts CountingBus<BUS, BINS>::counts_;
+
+template <typename BUS, uint8_t BINS>
+uint32_t CountingBus<BUS, BINS>::bins_[BINS > 0 ? BINS : 1];
+
+// Cache reads from BUS in a direct-mapped cache of LINES lines of LINE words
+// Writes go through to BUS and update cached lines. Call invalidate if the
+// target may have changed memory; config_float invalidates everything.
+template <typename BUS, uint8_t LINE = 16, uint8_t LINES = 8>
+struct ShadowBus : BaseBus {
+  static_assert(util::is_power_of_two(LINE), "LINE must be a power of two");
+  static_assert(util::is_power_of_two(LINES), "LINES must be a power of two");
+  using ADDRESS_TYPE = typename BUS::ADDRESS_TYPE;
+  using DATA_TYPE = typename BUS::DATA_TYPE;
+
+  static void config_write() { BUS::config_write(); }
+  static void config_read() { BUS::config_read(); }
+
+  static void config_float() {
+    // Target may write memory while it owns the bus
+    invalidate();
+    BUS::config_float();
+  }
+
+  static void flush_write() { BUS::flush_write(); }
+  static bool write_failed() { return io::write_failed<BUS>(); }
+
+  // Read through cache, filling line from BUS on miss
+  static DATA_TYPE read_bus(ADDRESS_TYPE addr) {
+    const ADDRESS_TYPE base = addr & ADDRESS_TYPE(~(LINE - 1));
+    const uint8_t slot = (addr / LINE) & (LINES - 1);
+    if (!valid_[slot] || tags_[slot] != base) {
+      io::read_block<BUS>(base, lines_[slot], LINE);
+      tags_[slot] = base;
+      valid_[slot] = true;
+    }
+    return lines_[slot][addr & (LINE - 1)];
+  }
+
+  static void read_block(ADDRESS_TYPE addr, DATA_TYPE* buf, uint16_t n) {
+    for (uint16_t i = 0; i < n; ++i) {
+      buf[i] = read_bus(addr + i);
+    }
+  }
+
+  static void write_bus(ADDRESS_TYPE addr, DATA_TYPE data) {
+    BUS::write_bus(addr, data);
+    update(addr, data);
+  }
+
+  static void write_block(ADDRESS_TYPE addr, const DATA_TYPE* buf, uint16_t n) {
+    io::write_block<BUS>(addr, buf, n);
+    for (uint16_t i = 0; i < n; ++i) {
+      update(addr + i, buf[i]);
+    }
+  }
+
+  // Discard all cached lines
+  static void invalidate() {
+    for (bool& valid : valid_) {
+      valid = false;
+    }
+  }
+
+  // Discard cached lines overlapping [addr, addr+n)
+  static void invalidate(ADDRESS_TYPE addr, uint16_t n) {
+    const ADDRESS_TYPE base = addr & ADDRESS_TYPE(~(LINE - 1));
+    const uint32_t span = uint32_t(addr - base) + n;
+    for (uint8_t slot = 0; slot < LINES; ++slot) {
+      if (ADDRESS_TYPE(tags_[slot] - base) < span) {
+        valid_[slot] = false;
+      }
+    }
+  }
+
+private:
+  // Write-through to cached line if present
+  static void update(ADDRESS_TYPE addr, DATA_TYPE data) {
+    const uint8_t slot = (addr / LINE) & (LINES - 1);
+    if (valid_[slot] && tags_[slot] == ADDRESS_TYPE(addr & ADDRESS_TYPE(~(LINE - 1)))) {
+      lines_[slot][addr & (LINE - 1)] = data;
+    }
+  }
+
+  static bool valid_[LINES];
+  static ADDRESS_TYPE tags_[LINES];
+  static DATA_TYPE lines_[LINES][LINE];
+};
+
+template <typename BUS, uint8_t LINE, uint8_t LINES>
+bool ShadowBus<BUS, LINE, LINES>::valid_[LINES];
+
+template <typename BUS, uint8_t LINE, uint8_t LINES>
+typename BUS::ADDRESS_TYPE ShadowBus<BUS, LINE, LINES>::tags_[LINES];
+
+template <typename BUS, uint8_t LINE, uint8_t LINES>
+typename BUS::DATA_TYPE ShadowBus<BUS, LINE, LINES>::lines_[LINES][LINE];
+
+// Read back before writing and skip words that already hold the value
+// Saves EEPROM/flash write cycles when reprogramming mostly unchanged images.
+// Can wrap PageWriteBus, which serves reads of pending words from its buffer.
+// Sequential write_bus calls are collected into blocks of up to BUF_SIZE words,
+// so each block is read back with one bus turnaround instead of one per word.
+template <typename BUS, uint8_t BUF_SIZE = 16>
+struct DiffWriteBus : BaseBus {
+  using ADDRESS_TYPE = typename BUS::ADDRESS_TYPE;
+  using DATA_TYPE = typename BUS::DATA_TYPE;
+
+  static void config_write() { BUS::config_write(); }
+
+  static void config_read() {
+    commit();
+    BUS::config_read();
+  }
+
+  static void config_float() {
+    commit();
+    BUS::config_float();
+  }
+
+  static void flush_write() {
+    commit();
+    BUS::flush_write();
+  }
+
+  static bool write_failed() { return io::write_failed<BUS>(); }
+
+  static DATA_TYPE read_bus(ADDRESS_TYPE addr) {
+    commit();
+    return BUS::read_bus(addr);
+  }
+
+  static void read_block(ADDRESS_TYPE addr, DATA_TYPE* buf, uint16_t n) {
+    commit();
+    io::read_block<BUS>(addr, buf, n);
+  }
+
+  // Held until the run is broken, the buffer fills, or the bus is read or flushed
+  static void write_bus(ADDRESS_TYPE addr, DATA_TYPE data) {
+    if (count_ == BUF_SIZE || (count_ > 0 && addr != ADDRESS_TYPE(start_ + count_))) {
+      commit();
+    }
+    if (count_ == 0) {
+      start_ = addr;
+    }
+    pending_[count_++] = data;
+  }
+
+  // Compare in chunks of BUF_SIZE to limit bus turnarounds
+  static void write_block(ADDRESS_TYPE addr, const DATA_TYPE* buf, uint16_t n) {
+    commit();
+    write_diff(addr, buf, n);
+  }
+
+  static uint32_t written() { return written_; }
+  static uint32_t skipped() { return skipped_; }
+
+  static void reset() {
+    written_ = 0;
+    skipped_ = 0;
+  }
+
+private:
+  // Write pending words collected by write_bus
+  static void commit() {
+    if (count_ > 0) {
+      const uint8_t n = count_;
+      count_ = 0;
+      write_diff(start_, pending_, n);
+    }
+  }
+
+  static void write_diff(ADDRESS_TYPE addr, const DATA_TYPE* buf, uint16_t n) {
+    DATA_TYPE prev[BUF_SIZE];
+    while (n > 0) {
+      const uint8_t size = n < BUF_SIZE ? n : BUF_SIZE;
+      BUS::config_read();
+      io::read_block<BUS>(addr, prev, size);
+      BUS::config_write();
+      // Write each run of differing words as a block
+      for (uint8_t i = 0; i < size; ) {
+        if (prev[i] == buf[i]) {
+          ++skipped_;
+          ++i;
+          continue;
+        }
+        uint8_t end = i + 1;
+        while (end < size && prev[end] != buf[end]) {
+          ++end;
+        }
+        io::write_block<BUS>(addr + i, buf + i, end - i);
+        written_ += end - i;
+        i = end;
+      }
+      addr += size;
+      buf += size;
+      n -= size;
+    }
+  }
+
+  static uint32_t written_;
+  static uint32_t skipped_;
+  static DATA_TYPE pending_[BUF_SIZE];
+  static ADDRESS_TYPE start_;
+  static uint8_t count_;
+};
+
+template <typename BUS, uint8_t BUF_SIZE>
+uint32_t DiffWriteBus<BUS, BUF_SIZE>::written_;
+
+template <typename BUS, uint8_t BUF_SIZE>
+typename BUS::DATA_TYPE DiffWriteBus<BUS, BUF_SIZE>::pending_[BUF_SIZE];
+
+template <typename BUS, uint8_t BUF_SIZE>
+typename BUS::ADDRESS_TYPE DiffWriteBus<BUS, BUF_SIZE>::start_;
+
+template <typename BUS, uint8_t BUF_SIZE>
+uint8_t DiffWriteBus<BUS, BUF_SIZE>::count_;
+
+template <typename BUS, uint8_t BUF_SIZE>
+uint32_t DiffWriteBus<BUS, BUF_SIZE>::skipped_;
+
+// Buffer writes to EEPROM (e.g. 28C256) and program a whole page in one burst
+// Pending page is written when another page is addressed or on flush_write
+// Completion is detected by DATA# polling, or by toggle-bit polling if TOGGLE_POLL
+template <typename BUS, uint8_t PAGE_SIZE = 64, bool TOGGLE_POLL = false>
+struct PageWriteBus : BaseBus {
+  static_assert(util::is_power_of_two(PAGE_SIZE), "PAGE_SIZE must be a power of two");
+  using ADDRESS_TYPE = typename BUS::ADDRESS_TYPE;
+  using DATA_TYPE = typename BUS::DATA_TYPE;
+
+  // Max reads while polling; at ~1us per read this comfortably exceeds tWC
+  static constexpr uint16_t POLL_LIMIT = 0xFFFF;
+
+  static void config_write() {
+    mode_ = BusMode::WRITE;
+    BUS::config_write();
+  }
+
+  static void config_read() {
+    mode_ = BusMode::READ;
+    BUS::config_read();
+  }
+
+  static void config_float() {
+    // Program pending page before releasing the bus
+    flush_write();
+    mode_ = BusMode::FLOAT;
+    BUS::config_float();
+  }
+
+  static void write_bus(ADDRESS_TYPE addr, DATA_TYPE data) {
+    const ADDRESS_TYPE page = addr & ADDRESS_TYPE(~(PAGE_SIZE - 1));
+    if (pending_ && page != page_) {
+      flush_write();
+    }
+    const uint8_t offset = addr & (PAGE_SIZE - 1);
+    page_ = page;
+    pending_ = true;
+    buffer_[offset] = data;
+    loaded_[offset / 8] |= 1 << (offset % 8);
+  }
+
+  static void write_block(ADDRESS_TYPE addr, const DATA_TYPE* buf, uint16_t n) {
+    for (uint16_t i = 0; i < n; ++i) {
+      write_bus(addr + i, buf[i]);
+    }
+  }
+
+  // Read pending data from buffer, otherwise from the device
+  static DATA_TYPE read_bus(ADDRESS_TYPE addr) {
+    DATA_TYPE data;
+    return read_pending(addr, data) ? data : BUS::read_bus(addr);
+  }
+
+  static void read_block(ADDRESS_TYPE addr, DATA_TYPE* buf, uint16_t n) {
+    io::read_block<BUS>(addr, buf, n);
+    if (pending_) {
+      for (uint16_t i = 0; i < n; ++i) {
+        read_pending(addr + i, buf[i]);
+      }
+    }
+  }
+
+  // Program pending page and wait for completion
+  static void flush_write() {
+    if (!pending_) return;
+    pending_ = false;
+
+    // Load bytes back to back; each must follow the last within tBLC
+    BUS::config_write();
+    ADDRESS_TYPE last_addr = page_;
+    DATA_TYPE last_data = 0;
+    for (uint8_t i = 0; i < PAGE_SIZE; ++i) {
+      if (loaded_[i / 8] & (1 << (i % 8))) {
+        last_addr = page_ + i;
+        last_data = buffer_[i];
+        BUS::write_bus(last_addr, last_data);
+      }
+    }
+    for (uint8_t& bits : loaded_) {
+      bits = 0;
+    }
+
+    // Poll last byte loaded until write cycle completes
+    BUS::config_read();
+    if (!poll(last_addr, last_data)) {
+      failed_ = true;
+    }
+
+    // Restore the direction selected by the caller
+    switch (mode_) {
+    case BusMode::WRITE: BUS::config_write(); break;
+    case BusMode::FLOAT: BUS::config_float(); break;
+    default: break;
+    }
+  }
+
+  // Return true if a page write timed out since the last call
+  // (e.g. no device present or write protected)
+  static bool write_failed() {
+    const bool failed = failed_;
+    failed_ = false;
+    return failed;
+  }
+
+  // Wait for write cycle to complete, returning false on timeout
+  static bool poll(ADDRESS_TYPE addr, DATA_TYPE data) {
+    DATA_TYPE prev = BUS::read_bus(addr);
+    for (uint16_t i = 0; i < POLL_LIMIT; ++i) {
+      const DATA_TYPE next = BUS::read_bus(addr);
+      if (TOGGLE_POLL) {
+        // I/O6 toggles on each read while write cycle is in progress
+        if (((prev ^ next) & 0x40) == 0) return true;
+        prev = next;
+      } else {
+        // I/O7 reads as complement of written data until complete
+        if (next == data) return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  static bool read_pending(ADDRESS_TYPE addr, DATA_TYPE& data) {
+    const uint8_t offset = addr & (PAGE_SIZE - 1);
+    if (pending_ && ADDRESS_TYPE(addr - offset) == page_
+        && (loaded_[offset / 8] & (1 << (offset % 8)))) {
+      data = buffer_[offset];
+      return true;
+    }
+    return false;
+  }
+
+  static BusMode mode_;
+  static bool pending_;
+  static bool failed_;
+  static ADDRESS_TYPE page_;
+  static DATA_TYPE buffer_[PAGE_SIZE];
+  static uint8_t loaded_[(PAGE_SIZE + 7) / 8];
 };
 
+template <typename BUS, uint8_t PAGE_SIZE, bool TOGGLE_POLL>
+BusMode PageWriteBus<BUS, PAGE_SIZE, TOGGLE_POLL>::mode_;
+
+template <typename BUS, uint8_t PAGE_SIZE, bool TOGGLE_POLL>
+bool PageWriteBus<BUS, PAGE_SIZE, TOGGLE_POLL>::pending_;
+
+template <typename BUS, uint8_t PAGE_SIZE, bool TOGGLE_POLL>
+bool PageWriteBus<BUS, PAGE_SIZE, TOGGLE_POLL>::failed_;
+
+template <typename BUS, uint8_t PAGE_SIZE, bool TOGGLE_POLL>
+typename BUS::ADDRESS_TYPE PageWriteBus<BUS, PAGE_SIZE, TOGGLE_POLL>::page_;
+
+template <typename BUS, uint8_t PAGE_SIZE, bool TOGGLE_POLL>
+typename BUS::DATA_TYPE PageWriteBus<BUS, PAGE_SIZE, TOGGLE_POLL>::buffer_[PAGE_SIZE];
+
+template <typename BUS, uint8_t PAGE_SIZE, bool TOGGLE_POLL>
+uint8_t PageWriteBus<BUS, PAGE_SIZE, TOGGLE_POLL>::loaded_[(PAGE_SIZE + 7) / 8];
+
 // Use CORE_ARRAY_BUS(array, address_t) to generate template parameters
 template <typename DATA, typename ADDRESS, ADDRESS SIZE, DATA (&ARRAY)[SIZE]>
 struct ArrayBus : BaseBus {
@@ -136,10 +1113,158 @@ struct ArrayBus : BaseBus {
   static void config_float() {}
   static DATA_TYPE read_bus(ADDRESS_TYPE addr) { return ARRAY[addr % SIZE]; }
   static void write_bus(ADDRESS_TYPE addr, DATA_TYPE data) { ARRAY[addr % SIZE] = data; }
+  static void read_block(ADDRESS_TYPE addr, DATA_TYPE* buf, uint16_t n) {
+    for (uint16_t i = 0; i < n; ++i) {
+      buf[i] = ARRAY[ADDRESS_TYPE(addr + i) % SIZE];
+    }
+  }
+  static void write_block(ADDRESS_TYPE addr, const DATA_TYPE* buf, uint16_t n) {
+    for (uint16_t i = 0; i < n; ++i) {
+      ARRAY[ADDRESS_TYPE(addr + i) % SIZE] = buf[i];
+    }
+  }
 };
 
+// Rough costs in CPU cycles for PortBus on a 16 MHz AVR with SRAM attached
+// Derive and override members to model other hardware
+struct SimTiming {
+  static constexpr uint32_t CLOCK_HZ = 16000000;
+  static constexpr uint32_t CALL = 8; // per read_bus/write_bus or block call
+  static constexpr uint32_t ADDRESS_PORT = 2; // per address byte changed
+  static constexpr uint32_t READ = 7; // RE strobe including tOE delay
+  static constexpr uint32_t WRITE = 6; // WE strobe
+  static constexpr uint32_t CONFIG = 16; // per config_write/read/float
+  static constexpr uint32_t WRITE_CYCLE = 0; // programming time per page written
+  static constexpr uint32_t PAGE_SIZE = 1; // words programmed by one write cycle
+  static constexpr uint32_t BYTE_LOAD = 0; // max time between loads to one page (tBLC)
+};
+
+// EEPROM (e.g. 28C256) with up to 10 ms page write cycle
+struct SimTimingEEPROM : SimTiming {
+  static constexpr uint32_t WRITE_CYCLE = CLOCK_HZ / 100;
+  static constexpr uint32_t PAGE_SIZE = 64;
+  static constexpr uint32_t BYTE_LOAD = CLOCK_HZ / 1000000 * 150;
+};
+
+// ArrayBus that estimates the time the same traffic would take on hardware
+// Use CORE_SIM_BUS(array, address_t) in place of CORE_ARRAY_BUS for benchmarks
+// Writes are loaded into a page as on EEPROM; a write cycle is charged when a
+// write follows the previous one by more than BYTE_LOAD or crosses to another
+// page, or when loading is ended by a read or flush
+template <typename DATA, typename ADDRESS, ADDRESS SIZE, DATA (&ARRAY)[SIZE], typename TIMING = SimTiming>
+struct SimBus : ArrayBus<DATA, ADDRESS, SIZE, ARRAY> {
+  using BASE = ArrayBus<DATA, ADDRESS, SIZE, ARRAY>;
+  using DATA_TYPE = DATA;
+  using ADDRESS_TYPE = ADDRESS;
+
+  static void config_write() { cycles_ += TIMING::CONFIG; }
+  static void config_read() { cycles_ += TIMING::CONFIG; }
+  static void config_float() { cycles_ += TIMING::CONFIG; }
+
+  static void flush_write() { finish_write(); }
+
+  static DATA_TYPE read_bus(ADDRESS_TYPE addr) {
+    finish_write();
+    cycles_ += TIMING::CALL + TIMING::READ + sizeof(ADDRESS_TYPE) * TIMING::ADDRESS_PORT;
+    return BASE::read_bus(addr);
+  }
+
+  static void write_bus(ADDRESS_TYPE addr, DATA_TYPE data) {
+    load(addr, TIMING::CALL + TIMING::WRITE + sizeof(ADDRESS_TYPE) * TIMING::ADDRESS_PORT);
+    BASE::write_bus(addr, data);
+  }
+
+  static void read_block(ADDRESS_TYPE addr, DATA_TYPE* buf, uint16_t n) {
+    finish_write();
+    cycles_ += TIMING::CALL + n * TIMING::READ + sequential_cost(addr, n);
+    BASE::read_block(addr, buf, n);
+  }
+
+  static void write_block(ADDRESS_TYPE addr, const DATA_TYPE* buf, uint16_t n) {
+    for (uint16_t i = 0; i < n; ++i) {
+      const ADDRESS_TYPE next = addr + i;
+      // Seek on first word, then only the address ports that change
+      load(next, TIMING::WRITE + (i == 0
+        ? TIMING::CALL + sizeof(ADDRESS_TYPE) * TIMING::ADDRESS_PORT
+        : ports_changed(next - 1, next) * TIMING::ADDRESS_PORT));
+    }
+    BASE::write_block(addr, buf, n);
+  }
+
+  // Estimated time since reset; 64-bit since writing 32K bytes to EEPROM one
+  // write cycle at a time exceeds 2^32 cycles
+  static uint64_t cycles() { return cycles_; }
+  static uint64_t micros() { return cycles_ / (TIMING::CLOCK_HZ / 1000000); }
+
+  static void reset() {
+    cycles_ = 0;
+    writing_ = false;
+  }
+
+private:
+  static uint8_t ports_changed(ADDRESS_TYPE prev, ADDRESS_TYPE addr) {
+    uint8_t ports = 0;
+    for (ADDRESS_TYPE diff = prev ^ addr; diff != 0; diff >>= 8) {
+      ++ports;
+    }
+    return ports;
+  }
+
+  // Charge address ports written by seek(addr) and the following increments
+  static uint32_t sequential_cost(ADDRESS_TYPE addr, uint16_t n) {
+    uint32_t ports = sizeof(ADDRESS_TYPE);
+    for (uint16_t i = 1; i < n; ++i, ++addr) {
+      ports += ports_changed(addr, addr + 1);
+    }
+    return ports * TIMING::ADDRESS_PORT;
+  }
+
+  // Charge cost of loading one word, after the write cycle for the previous
+  // page if this load can't join it
+  static void load(ADDRESS_TYPE addr, uint32_t cost) {
+    const uint32_t page = uint32_t(addr) / TIMING::PAGE_SIZE;
+    if (writing_ && (page != page_ || cycles_ + cost - loaded_ > TIMING::BYTE_LOAD)) {
+      finish_write();
+    }
+    cycles_ += cost;
+    loaded_ = cycles_;
+    writing_ = true;
+    page_ = page;
+  }
+
+  static void finish_write() {
+    if (writing_) {
+      writing_ = false;
+      cycles_ += TIMING::WRITE_CYCLE;
+    }
+  }
+
+  static uint64_t cycles_;
+  static uint64_t loaded_; // cycles_ at end of last load
+  static uint32_t page_;
+  static bool writing_;
+};
+
+template <typename DATA, typename ADDRESS, ADDRESS SIZE, DATA (&ARRAY)[SIZE], typename TIMING>
+uint64_t SimBus<DATA, ADDRESS, SIZE, ARRAY, TIMING>::cycles_;
+
+template <typename DATA, typename ADDRESS, ADDRESS SIZE, DATA (&ARRAY)[SIZE], typename TIMING>
+uint64_t SimBus<DATA, ADDRESS, SIZE, ARRAY, TIMING>::loaded_;
+
+template <typename DATA, typename ADDRESS, ADDRESS SIZE, DATA (&ARRAY)[SIZE], typename TIMING>
+uint32_t SimBus<DATA, ADDRESS, SIZE, ARRAY, TIMING>::page_;
+
+template <typename DATA, typename ADDRESS, ADDRESS SIZE, DATA (&ARRAY)[SIZE], typename TIMING>
+bool SimBus<DATA, ADDRESS, SIZE, ARRAY, TIMING>::writing_;
+
 } // namespace io
 } // namespace core
 
 // Create a Bus-like read/write interface around an array with the given address type
 #define CORE_ARRAY_BUS(ARRAY, ADDRESS) core::io::ArrayBus<core::util::remove_reference<decltype(ARRAY[0])>::type, ADDRESS, core::util::array_length(ARRAY), ARRAY>
+
+// Same as CORE_ARRAY_BUS, but counts estimated hardware cycles
+#define CORE_SIM_BUS(ARRAY, ADDRESS) core::io::SimBus<core::util::remove_reference<decltype(ARRAY[0])>::type, ADDRESS, core::util::array_length(ARRAY), ARRAY>
+
+// Same as CORE_SIM_BUS with costs given by TIMING (see SimTiming)
+#define CORE_SIM_BUS_TIMED(ARRAY, ADDRESS, TIMING) core::io::SimBus<core::util::remove_reference<decltype(ARRAY[0])>::type, ADDRESS, core::util::array_length(ARRAY), ARRAY, TIMING>
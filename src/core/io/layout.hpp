@@ -0,0 +1,225 @@
+// Copyright (c) 2023 Trevor Makes
+
+#pragma once
+
+#include "core/util.hpp"
+
+#include <stdint.h>
+
+namespace core {
+namespace io {
+
+// Bits of a port value that map to physical register REG of type TYPE
+// Value bits land at (value << SHIFT) & MASK, shifting right if SHIFT < 0
+// The value type V may be wider than TYPE (e.g. one byte of a WordExtend)
+template <typename R, typename T, T M, int8_t S>
+struct Component {
+  using REG = R;
+  using TYPE = T;
+  static constexpr TYPE MASK = M;
+  static constexpr int8_t SHIFT = S;
+
+  // Move value bits to register position
+  template <typename V>
+  static constexpr TYPE pack(V value) {
+    return TYPE(V(V(value << (S > 0 ? S : 0)) >> (S < 0 ? -S : 0))) & M;
+  }
+
+  // Move register bits to value position
+  template <typename V>
+  static constexpr V unpack(TYPE reg) {
+    return V(V(TYPE(reg & M) >> (S > 0 ? S : 0)) << (S < 0 ? -S : 0));
+  }
+};
+
+// List of components making up a port
+// Ports may define `using LAYOUT = Layout<...>` so that composite ports
+// (Overlay, BitExtend) can merge accesses to the same physical register
+template <typename... C>
+struct Layout {};
+
+// Use PORT::LAYOUT if defined
+template <typename PORT>
+auto layout_of_impl(int) -> typename PORT::LAYOUT;
+
+// Otherwise treat PORT as its own register
+template <typename PORT>
+auto layout_of_impl(long) -> Layout<Component<PORT, typename PORT::TYPE, PORT::MASK, 0>>;
+
+template <typename PORT>
+using layout_of = decltype(layout_of_impl<PORT>(0));
+
+// Join two layouts
+template <typename A, typename B>
+struct layout_concat;
+
+template <typename... A, typename... B>
+struct layout_concat<Layout<A...>, Layout<B...>> {
+  using type = Layout<A..., B...>;
+};
+
+// Add BITS to the shift of each component
+template <typename L, int8_t BITS>
+struct layout_shift;
+
+template <typename... C, int8_t BITS>
+struct layout_shift<Layout<C...>, BITS> {
+  using type = Layout<Component<typename C::REG, typename C::TYPE, C::MASK, C::SHIFT + BITS>...>;
+};
+
+// Split layout into components in REG (same) and all others (other)
+template <typename REG, typename L>
+struct layout_split;
+
+template <typename REG>
+struct layout_split<REG, Layout<>> {
+  using same = Layout<>;
+  using other = Layout<>;
+};
+
+template <typename REG, typename C, typename... Cs>
+struct layout_split<REG, Layout<C, Cs...>> {
+  using rest = layout_split<REG, Layout<Cs...>>;
+  static constexpr bool match = util::is_same<REG, typename C::REG>::value;
+  using with_c = typename layout_concat<Layout<C>, typename rest::same>::type;
+  using without_c = typename layout_concat<Layout<C>, typename rest::other>::type;
+  using same = typename util::conditional<match, with_c, typename rest::same>::type;
+  using other = typename util::conditional<match, typename rest::other, without_c>::type;
+};
+
+// Combine components sharing one register of type R, for values of type V
+template <typename V, typename R, typename L>
+struct layout_bits;
+
+template <typename V, typename R>
+struct layout_bits<V, R, Layout<>> {
+  static constexpr R MASK = 0;
+  static constexpr bool DISJOINT = true;
+  static constexpr R pack(V) { return 0; }
+  static constexpr V unpack(R) { return 0; }
+};
+
+template <typename V, typename R, typename C, typename... Cs>
+struct layout_bits<V, R, Layout<C, Cs...>> {
+  using rest = layout_bits<V, R, Layout<Cs...>>;
+  static constexpr R MASK = C::MASK | rest::MASK;
+  static constexpr bool DISJOINT = (C::MASK & rest::MASK) == 0 && rest::DISJOINT;
+  static constexpr R pack(V value) { return C::template pack<V>(value) | rest::pack(value); }
+  static constexpr V unpack(R reg) { return C::template unpack<V>(reg) | rest::unpack(reg); }
+};
+
+// Select MASK bits within REG, or REG itself if MASK selects all of its bits
+template <typename REG, typename REG::TYPE MASK, bool = (MASK == REG::MASK)>
+struct masked_reg {
+  using type = typename REG::template Mask<MASK>;
+};
+
+template <typename REG, typename REG::TYPE MASK>
+struct masked_reg<REG, MASK, true> {
+  using type = REG;
+};
+
+// Port operations applied with one access per physical register in layout
+// T is the port value type, which may be wider than the registers
+template <typename T, typename L>
+struct LayoutOps;
+
+template <typename T>
+struct LayoutOps<T, Layout<>> {
+  static inline void bitwise_xor(T) {}
+  static inline void bitwise_or(T) {}
+  static inline void bitwise_and(T) {}
+  static inline void write(T) {}
+  static inline void write_changed(T, T) {}
+  static inline void set() {}
+  static inline void clear() {}
+  static inline void flip() {}
+  static inline T read() { return 0; }
+  static inline bool is_set() { return true; }
+  static inline bool is_clear() { return true; }
+  static inline void config_output() {}
+  static inline void config_input() {}
+  static inline void config_input_pullups() {}
+};
+
+template <typename T, typename C, typename... Cs>
+struct LayoutOps<T, Layout<C, Cs...>> {
+  using SPLIT = layout_split<typename C::REG, Layout<C, Cs...>>;
+  using BITS = layout_bits<T, typename C::TYPE, typename SPLIT::same>;
+  using REG = typename masked_reg<typename C::REG, BITS::MASK>::type;
+  using NEXT = LayoutOps<T, typename SPLIT::other>;
+  static_assert(BITS::DISJOINT, "Port components overlap within the same register");
+
+  static inline void bitwise_xor(T value) {
+    REG::bitwise_xor(BITS::pack(value));
+    NEXT::bitwise_xor(value);
+  }
+
+  static inline void bitwise_or(T value) {
+    REG::bitwise_or(BITS::pack(value));
+    NEXT::bitwise_or(value);
+  }
+
+  static inline void bitwise_and(T value) {
+    REG::bitwise_and(BITS::pack(value));
+    NEXT::bitwise_and(value);
+  }
+
+  static inline void write(T value) {
+    REG::write(BITS::pack(value));
+    NEXT::write(value);
+  }
+
+  // Skip registers whose bits are the same in prev and value
+  static inline void write_changed(T prev, T value) {
+    if (BITS::pack(prev) != BITS::pack(value)) {
+      REG::write(BITS::pack(value));
+    }
+    NEXT::write_changed(prev, value);
+  }
+
+  static inline void set() {
+    REG::set();
+    NEXT::set();
+  }
+
+  static inline void clear() {
+    REG::clear();
+    NEXT::clear();
+  }
+
+  static inline void flip() {
+    REG::flip();
+    NEXT::flip();
+  }
+
+  static inline T read() {
+    return BITS::unpack(REG::read()) | NEXT::read();
+  }
+
+  static inline bool is_set() {
+    return REG::is_set() && NEXT::is_set();
+  }
+
+  static inline bool is_clear() {
+    return REG::is_clear() && NEXT::is_clear();
+  }
+
+  static inline void config_output() {
+    REG::config_output();
+    NEXT::config_output();
+  }
+
+  static inline void config_input() {
+    REG::config_input();
+    NEXT::config_input();
+  }
+
+  static inline void config_input_pullups() {
+    REG::config_input_pullups();
+    NEXT::config_input_pullups();
+  }
+};
+
+} // namespace io
+} // namespace core
@@ -0,0 +1,148 @@
+// Copyright (c) 2023 Trevor Makes
+
+#pragma once
+
+// Native (POSIX) only: bus backed by a memory-mapped image file
+
+#include "core/io/bus.hpp"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace core {
+namespace io {
+
+enum class MmapMode : uint8_t {
+  READ_ONLY,  // writes are ignored
+  READ_WRITE, // writes are saved to file on flush_write or close
+  COPY,       // writes are kept in memory and discarded on close
+};
+
+// Bus over a binary image file mapped into the address space
+// Addresses wrap modulo the file size, like ArrayBus; reads return 0 when
+// no file is open. Use ID to declare more than one independent mapping.
+template <typename ADDRESS = uint16_t, uint8_t ID = 0>
+struct MmapBus : BaseBus {
+  using DATA_TYPE = uint8_t;
+  using ADDRESS_TYPE = ADDRESS;
+
+  // Map file at path, replacing any open mapping; return false on failure
+  static bool open(const char* path, MmapMode mode = MmapMode::READ_ONLY) {
+    close();
+    const bool writable = mode == MmapMode::READ_WRITE;
+    const int fd = ::open(path, writable ? O_RDWR : O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      ::close(fd);
+      return false;
+    }
+    const int prot = mode == MmapMode::READ_ONLY ? PROT_READ : PROT_READ | PROT_WRITE;
+    const int flags = writable ? MAP_SHARED : MAP_PRIVATE;
+    void* map = mmap(nullptr, size_t(st.st_size), prot, flags, fd, 0);
+    // Mapping remains valid after fd is closed
+    ::close(fd);
+    if (map == MAP_FAILED) {
+      return false;
+    }
+    data_ = static_cast<uint8_t*>(map);
+    size_ = size_t(st.st_size);
+    mode_ = mode;
+    return true;
+  }
+
+  // Unmap file, saving writes if opened READ_WRITE
+  static void close() {
+    if (data_ != nullptr) {
+      flush_write();
+      munmap(data_, size_);
+      data_ = nullptr;
+      size_ = 0;
+    }
+  }
+
+  static bool is_open() { return data_ != nullptr; }
+
+  // Direct access to mapped image
+  static uint8_t* data() { return data_; }
+  static size_t size() { return size_; }
+
+  static void config_write() {}
+  static void config_read() {}
+  static void config_float() {}
+
+  static void flush_write() {
+    if (data_ != nullptr && mode_ == MmapMode::READ_WRITE) {
+      msync(data_, size_, MS_SYNC);
+    }
+  }
+
+  static DATA_TYPE read_bus(ADDRESS_TYPE addr) {
+    return size_ > 0 ? data_[size_t(addr) % size_] : 0;
+  }
+
+  static void write_bus(ADDRESS_TYPE addr, DATA_TYPE data) {
+    if (is_writable()) {
+      data_[size_t(addr) % size_] = data;
+    }
+  }
+
+  // Copy in contiguous runs, splitting where addr wraps at end of image
+  static void read_block(ADDRESS_TYPE addr, DATA_TYPE* buf, uint16_t n) {
+    if (size_ == 0) {
+      memset(buf, 0, n);
+      return;
+    }
+    while (n > 0) {
+      const size_t offset = size_t(addr) % size_;
+      const uint16_t run = min_run(offset, n);
+      memcpy(buf, data_ + offset, run);
+      addr += run;
+      buf += run;
+      n -= run;
+    }
+  }
+
+  static void write_block(ADDRESS_TYPE addr, const DATA_TYPE* buf, uint16_t n) {
+    if (!is_writable()) {
+      return;
+    }
+    while (n > 0) {
+      const size_t offset = size_t(addr) % size_;
+      const uint16_t run = min_run(offset, n);
+      memcpy(data_ + offset, buf, run);
+      addr += run;
+      buf += run;
+      n -= run;
+    }
+  }
+
+private:
+  static bool is_writable() { return size_ > 0 && mode_ != MmapMode::READ_ONLY; }
+
+  static uint16_t min_run(size_t offset, uint16_t n) {
+    return size_ - offset < n ? uint16_t(size_ - offset) : n;
+  }
+
+  static uint8_t* data_;
+  static size_t size_;
+  static MmapMode mode_;
+};
+
+template <typename ADDRESS, uint8_t ID>
+uint8_t* MmapBus<ADDRESS, ID>::data_ = nullptr;
+
+template <typename ADDRESS, uint8_t ID>
+size_t MmapBus<ADDRESS, ID>::size_ = 0;
+
+template <typename ADDRESS, uint8_t ID>
+MmapMode MmapBus<ADDRESS, ID>::mode_ = MmapMode::READ_ONLY;
+
+} // namespace io
+} // namespace core
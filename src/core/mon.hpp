@@ -3,90 +3,252 @@
 #pragma once
 
 #include "mon/api.hpp"
+#include "mon/crc.hpp"
 #include "mon/format.hpp"
 #include "core/cli.hpp"
+#include "core/io/bus.hpp"
 
 #include <stdint.h>
+#include <string.h>
 #include <ctype.h>
 
 namespace core {
 namespace mon {
 
-template <typename API, uint8_t COL_SIZE = 16, uint8_t MAX_ROWS = 24>
-uint16_t impl_hex(uint16_t row, uint16_t end) {
-  API::BUS::config_read();
+// Address type used by commands: BUS::ADDRESS_TYPE, but at least 16 bits
+template <typename API>
+using address_t = typename util::conditional<(sizeof(typename API::BUS::ADDRESS_TYPE) > 2),
+  typename API::BUS::ADDRESS_TYPE, uint16_t>::type;
 
-  uint8_t row_data[COL_SIZE];
-  for (uint8_t i = 0; i < MAX_ROWS; ++i) {
-    // Read row into temp buffer
-    for (uint8_t j = 0; j < COL_SIZE; ++j) {
-      row_data[j] = API::BUS::read_bus(row + j);
-    }
+// Flush delayed writes, printing an error if the bus reports a failed write
+template <typename API>
+bool impl_flush() {
+  API::BUS::flush_write();
+  const bool failed = io::write_failed<typename API::BUS>();
+  CORE_FMT_ERROR(API, failed, "write", "", return false);
+  return true;
+}
 
-    // Print address
-    API::print_char(' ');
-    format_hex16(API::print_char, row);
+// Fallback for buses that don't count skipped writes
+template <typename API>
+void print_write_stats_impl(long) {}
+
+template <typename API>
+auto print_write_stats_impl(int) -> decltype(API::BUS::skipped(), void()) {
+  API::print_string("written $");
+  format_hex32(API::print_char, API::BUS::written());
+  API::print_string(" skipped $");
+  format_hex32(API::print_char, API::BUS::skipped());
+  API::newline();
+}
+
+// Print words written and skipped since io::reset_write_stats, if counted
+template <typename API>
+void print_write_stats() {
+  print_write_stats_impl<API>(0);
+}
+
+// Print row address, words in hex, and words as ASCII
+template <typename API, uint8_t COL_SIZE>
+void print_hex_row(address_t<API> row, const typename API::BUS::DATA_TYPE* row_data) {
+  using DATA = typename API::BUS::DATA_TYPE;
 
-    // Print hex data
-    for (uint8_t col = 0; col < COL_SIZE; ++col) {
+  // Print address
+  API::print_char(' ');
+  format_hex(API::print_char, row);
+
+  // Print hex data
+  for (uint8_t col = 0; col < COL_SIZE; ++col) {
+    API::print_char(' ');
+    if (col % 4 == 0) {
       API::print_char(' ');
-      if (col % 4 == 0) {
-        API::print_char(' ');
-      }
-      format_hex8(API::print_char, row_data[col]);
     }
+    format_hex(API::print_char, row_data[col]);
+  }
 
-    // Print string data
-    API::print_string("  \"");
-    for (uint8_t col = 0; col < COL_SIZE; ++col) {
-      format_ascii(API::print_char, row_data[col]);
+  // Print string data, lowest byte of each word first
+  API::print_string("  \"");
+  for (uint8_t col = 0; col < COL_SIZE; ++col) {
+    for (uint8_t lane = 0; lane < sizeof(DATA); ++lane) {
+      format_ascii(API::print_char, uint8_t(row_data[col] >> (8 * lane)));
     }
-    API::print_char('\"');
-    API::newline();
+  }
+  API::print_char('\"');
+  API::newline();
+}
+
+// Read and print rows for impl_hex
+// If COLLAPSE, runs of rows identical to the previous row print as a single *
+// line, like hexdump -C
+template <typename API, uint8_t COL_SIZE, bool COLLAPSE = true>
+class HexRows {
+  using DATA = typename API::BUS::DATA_TYPE;
+
+  DATA prev_[COL_SIZE];
+  bool has_prev_ = false;
+  bool skipping_ = false;
+
+public:
+  // Print row unless collapsed, always printing if last
+  // Returns true if a line was printed
+  bool print(address_t<API> row, bool last) {
+    DATA row_data[COL_SIZE];
+    io::read_block<typename API::BUS>(row, row_data, COL_SIZE);
+    if (COLLAPSE && !last && has_prev_ && memcmp(row_data, prev_, sizeof(row_data)) == 0) {
+      if (skipping_) return false;
+      skipping_ = true;
+      API::print_char('*');
+      API::newline();
+      return true;
+    }
+    print_hex_row<API, COL_SIZE>(row, row_data);
+    if (COLLAPSE) {
+      memcpy(prev_, row_data, sizeof(row_data));
+      has_prev_ = true;
+      skipping_ = false;
+    }
+    return true;
+  }
+};
 
+// Print up to MAX_ROWS lines from row to end, inclusive, returning next row
+// The last line is always a row, so the final address is shown
+template <typename API, uint8_t COL_SIZE = 16, uint8_t MAX_ROWS = 24, bool COLLAPSE = true>
+address_t<API> impl_hex(address_t<API> row, address_t<API> end) {
+  using ADDR = address_t<API>;
+  API::BUS::config_read();
+
+  HexRows<API, COL_SIZE, COLLAPSE> rows;
+  for (uint8_t i = 0; i < MAX_ROWS; ) {
     // Do while end does not overlap with row
-    uint16_t prev = row;
+    const bool is_end = ADDR(end - row) < COL_SIZE;
+    if (rows.print(row, is_end || i + 1 == MAX_ROWS)) {
+      ++i;
+    }
     row += COL_SIZE;
-    if (uint16_t(end - prev) < COL_SIZE) { break; }
+    if (is_end) { break; }
   }
   return row;
 }
 
 // Dump memory as hex/ascii from row to end, inclusive
-template <typename API, uint8_t COL_SIZE = 16, uint8_t MAX_ROWS = 24>
+// If MAX_ROWS is 0, stream the whole range with flow control instead of
+// stopping with a continuation prompt
+template <typename API, uint8_t COL_SIZE = 16, uint8_t MAX_ROWS = 24, bool COLLAPSE = true>
 void cmd_hex(cli::Args args) {
+  using ADDR = address_t<API>;
   // Default size to one row if not provided
-  CORE_EXPECT_ADDR(API, uint16_t, start, args, return);
-  CORE_OPTION_UINT(API, uint16_t, size, COL_SIZE, args, return);
-  uint16_t end_incl = start + size - 1;
-  uint16_t next = impl_hex<API, COL_SIZE, MAX_ROWS>(start, end_incl);
-  uint16_t part = next - start;
+  CORE_EXPECT_ADDR(API, ADDR, start, args, return);
+  CORE_OPTION_UINT(API, ADDR, size, COL_SIZE, args, return);
+  ADDR end_incl = start + size - 1;
+  if (MAX_ROWS == 0) {
+    HexRows<API, COL_SIZE, COLLAPSE> rows;
+    API::BUS::config_read();
+    for (ADDR row = start; stream_ready<API>(); row += COL_SIZE) {
+      const bool is_end = ADDR(end_incl - row) < COL_SIZE;
+      rows.print(row, is_end);
+      if (is_end) break;
+    }
+    return;
+  }
+  ADDR next = impl_hex<API, COL_SIZE, MAX_ROWS, COLLAPSE>(start, end_incl);
+  ADDR part = next - start;
   if (part < size) {
-    set_prompt<API>(args.command(), next, size - part);
+    set_prompt<API>(args.command(), next, ADDR(size - part));
+  }
+}
+
+// Dump memory as hex/ascii like cmd_hex, then re-read it every interval ms and
+// rewrite only the cells that changed, until any key is pressed
+// Size is limited to MAX_ROWS rows, so the whole range stays on screen
+template <typename API, uint8_t COL_SIZE = 16, uint8_t MAX_ROWS = 16>
+void cmd_watch(cli::Args args) {
+  using ADDR = address_t<API>;
+  using DATA = typename API::BUS::DATA_TYPE;
+  constexpr uint8_t LANES = sizeof(DATA);
+  // Columns of first hex and ASCII cells, as printed by print_hex_row
+  constexpr uint8_t HEX_START = 1 + 2 * sizeof(ADDR) + 2;
+  constexpr uint8_t ASCII_START = HEX_START - 2 + COL_SIZE * (1 + 2 * LANES) + (COL_SIZE + 3) / 4 + 3;
+  CORE_EXPECT_ADDR(API, ADDR, start, args, return);
+  CORE_OPTION_UINT(API, ADDR, size, COL_SIZE, args, return);
+  CORE_OPTION_UINT(API, uint16_t, interval, 100, args, return);
+  // Refuse ranges that don't fit on screen rather than watching part of them
+  CORE_FMT_ERROR(API, size == 0 || size > ADDR(COL_SIZE * MAX_ROWS), "size", "", return);
+  const uint8_t rows = (size + COL_SIZE - 1) / COL_SIZE;
+
+  // Print rows from the same reads used for comparison
+  DATA prev[COL_SIZE * MAX_ROWS];
+  API::BUS::config_read();
+  for (uint8_t row = 0; row < rows; ++row) {
+    const ADDR addr = start + row * COL_SIZE;
+    io::read_block<typename API::BUS>(addr, prev + row * COL_SIZE, COL_SIZE);
+    print_hex_row<API, COL_SIZE>(addr, prev + row * COL_SIZE);
   }
+  API::save_cursor();
+
+  uint32_t last = millis();
+  char c;
+  while (!API::try_input_char(c)) {
+    if (millis() - last < interval) continue;
+    last = millis();
+    API::BUS::config_read();
+    for (uint8_t row = 0; row < rows; ++row) {
+      DATA row_data[COL_SIZE];
+      DATA* prev_data = prev + row * COL_SIZE;
+      io::read_block<typename API::BUS>(start + row * COL_SIZE, row_data, COL_SIZE);
+      for (uint8_t col = 0; col < COL_SIZE; ++col) {
+        if (row_data[col] == prev_data[col]) continue;
+        prev_data[col] = row_data[col];
+        // Move from saved position below last row to hex cell
+        const uint8_t hex_col = HEX_START + col * (1 + 2 * LANES) + col / 4;
+        API::restore_cursor();
+        API::cursor_up(rows - row);
+        API::cursor_right(hex_col);
+        format_hex(API::print_char, row_data[col]);
+        // Move right to ASCII cells
+        API::cursor_right(ASCII_START + col * LANES - (hex_col + 2 * LANES));
+        for (uint8_t lane = 0; lane < LANES; ++lane) {
+          format_ascii(API::print_char, uint8_t(row_data[col] >> (8 * lane)));
+        }
+      }
+    }
+  }
+  API::restore_cursor();
 }
 
 // Write pattern from start to end, inclusive
-template <typename API>
-void impl_memset(uint16_t start, uint16_t end, uint8_t pattern) {
-  do {
-    API::BUS::write_bus(start, pattern);
-  } while (start++ != end);
+template <typename API, uint8_t BUF_SIZE = 16>
+void impl_memset(address_t<API> start, address_t<API> end, typename API::BUS::DATA_TYPE pattern) {
+  // Repeat pattern in buffer to write sequential blocks
+  typename API::BUS::DATA_TYPE buffer[BUF_SIZE];
+  for (auto& data : buffer) {
+    data = pattern;
+  }
+  for (;;) {
+    // Words remaining, less one (end - start + 1 overflows when filling 64K)
+    address_t<API> left = end - start;
+    uint8_t size = left < BUF_SIZE ? left + 1 : BUF_SIZE;
+    io::write_block<typename API::BUS>(start, buffer, size);
+    if (left < BUF_SIZE) break;
+    start += size;
+  }
 }
 
 template <typename API>
 void cmd_fill(cli::Args args) {
-  CORE_EXPECT_ADDR(API, uint16_t, start, args, return);
-  CORE_EXPECT_UINT(API, uint16_t, size, args, return);
-  CORE_EXPECT_UINT(API, uint8_t, pattern, args, return);
+  CORE_EXPECT_ADDR(API, address_t<API>, start, args, return);
+  CORE_EXPECT_UINT(API, address_t<API>, size, args, return);
+  CORE_EXPECT_UINT(API, typename API::BUS::DATA_TYPE, pattern, args, return);
+  io::reset_write_stats<typename API::BUS>();
   API::BUS::config_write();
   impl_memset<API>(start, start + size - 1, pattern);
-  API::BUS::flush_write();
+  impl_flush<API>();
+  print_write_stats<API>();
 }
 
 // Write string from start until null terminator
 template <typename API>
-uint16_t impl_strcpy(uint16_t start, const char* str) {
+address_t<API> impl_strcpy(address_t<API> start, const char* str) {
   for (;;) {
     char c = *str++;
     if (c == '\0') {
@@ -98,80 +260,127 @@ uint16_t impl_strcpy(uint16_t start, const char* str) {
 
 template <typename API>
 void cmd_set(cli::Args args) {
-  CORE_EXPECT_ADDR(API, uint16_t, start, args, return);
+  CORE_EXPECT_ADDR(API, address_t<API>, start, args, return);
   API::BUS::config_write();
   do {
     if (args.is_string()) {
       start = impl_strcpy<API>(start, args.next());
     } else {
-      CORE_EXPECT_UINT(API, uint8_t, data, args, return);
+      CORE_EXPECT_UINT(API, typename API::BUS::DATA_TYPE, data, args, return);
       API::BUS::write_bus(start++, data);
     }
   } while (args.has_next());
-  API::BUS::flush_write();
+  impl_flush<API>();
 }
 
 // Copy [start, end] to [dest, dest+end-start] (end inclusive)
-template <typename API>
-void impl_memmove(uint16_t start, uint16_t end, uint16_t dest) {
-  uint16_t delta = end - start;
-  uint16_t dest_end = dest + delta;
-  // Buses narrower than 16-bits introduce cases with ghosting (wrap-around).
+// Data is staged through a buffer of BUF_SIZE words so that the bus changes
+// direction twice per chunk rather than twice per word
+template <typename API, uint8_t BUF_SIZE = 32>
+void impl_memmove(address_t<API> start, address_t<API> end, address_t<API> dest) {
+  using ADDR = address_t<API>;
+  typename API::BUS::DATA_TYPE buffer[BUF_SIZE];
+  ADDR delta = end - start;
+  ADDR dest_end = dest + delta;
+  // Buses narrower than ADDR introduce cases with ghosting (wrap-around).
   // This logic should work as long as start and dest are both within [0, 2^N),
   // where N is the actual bus width.
   // See [notes/memmove.png]
   bool a = dest <= end;
   bool b = dest_end < start;
   bool c = dest > start;
-  if ((a && b) || (a && c) || (b && c)) {
-    // Reverse copy from end to start
-    for (uint16_t i = 0; i <= delta; ++i) {
-      API::BUS::config_read();
-      auto data = API::BUS::read_bus(end - i);
-      API::BUS::config_write();
-      API::BUS::write_bus(dest_end - i, data);
-    }
-  } else {
-    // Forward copy from start to end
-    for (uint16_t i = 0; i <= delta; ++i) {
-      API::BUS::config_read();
-      auto data = API::BUS::read_bus(start + i);
-      API::BUS::config_write();
-      API::BUS::write_bus(dest + i, data);
+  bool reverse = (a && b) || (a && c) || (b && c);
+  for (ADDR offset = 0; ; ) {
+    // Words remaining, less one (delta + 1 overflows when copying 64K)
+    ADDR left = delta - offset;
+    uint8_t size = left < BUF_SIZE ? left + 1 : BUF_SIZE;
+    ADDR src, dst;
+    if (reverse) {
+      // Reverse copy chunks from end to start
+      src = end - offset - (size - 1);
+      dst = dest_end - offset - (size - 1);
+    } else {
+      // Forward copy chunks from start to end
+      src = start + offset;
+      dst = dest + offset;
     }
+    // Each chunk is fully read before any of it is written, so overlap
+    // within a chunk is safe in either direction
+    API::BUS::config_read();
+    io::read_block<typename API::BUS>(src, buffer, size);
+    API::BUS::config_write();
+    io::write_block<typename API::BUS>(dst, buffer, size);
+    if (left < BUF_SIZE) break;
+    offset += size;
   }
-  API::BUS::flush_write();
+  impl_flush<API>();
 }
 
-template <typename API>
+template <typename API, uint8_t BUF_SIZE = 32>
 void cmd_move(cli::Args args) {
-  CORE_EXPECT_ADDR(API, uint16_t, start, args, return);
-  CORE_EXPECT_UINT(API, uint16_t, size, args, return);
-  CORE_EXPECT_ADDR(API, uint16_t, dest, args, return);
-  impl_memmove<API>(start, start + size - 1, dest);
+  CORE_EXPECT_ADDR(API, address_t<API>, start, args, return);
+  CORE_EXPECT_UINT(API, address_t<API>, size, args, return);
+  CORE_EXPECT_ADDR(API, address_t<API>, dest, args, return);
+  impl_memmove<API, BUF_SIZE>(start, start + size - 1, dest);
+}
+
+// Print IHX record header and return its checksum so far
+template <typename API>
+uint8_t print_ihx_header(uint8_t rec_size, uint16_t offset, uint8_t rec_type) {
+  API::print_char(':');
+  format_hex8(API::print_char, rec_size);
+  format_hex16(API::print_char, offset);
+  format_hex8(API::print_char, rec_type);
+  return rec_size + (offset >> 8) + (offset & 0xFF) + rec_type;
 }
 
 // Print memory range in IHX format
+// Words wider than 8 bits are split into bytes at address word*LANES + lane,
+// lowest byte first. Records are split at 64K boundaries; addresses above 64K
+// are preceded by an extended linear address record (04) with the upper 16 bits
 template <typename API, uint8_t REC_SIZE = 32>
-void impl_export(uint16_t start, uint16_t size) {
+void impl_export(address_t<API> start, address_t<API> size) {
+  using DATA = typename API::BUS::DATA_TYPE;
+  using BYTE_ADDR = typename util::conditional<sizeof(DATA) == 1, address_t<API>, uint32_t>::type;
+  constexpr uint8_t LANES = sizeof(DATA);
+  constexpr uint8_t REC_WORDS = REC_SIZE / LANES;
+  static_assert(REC_SIZE % LANES == 0, "REC_SIZE must be a multiple of word size");
   API::BUS::config_read();
+  DATA rec_data[REC_WORDS];
+  BYTE_ADDR addr = BYTE_ADDR(start) * LANES;
+  uint16_t upper = 0;
   while (size > 0) {
-    uint8_t rec_size = size > REC_SIZE ? REC_SIZE : size;
-    size -= rec_size;
+    const uint16_t offset = uint16_t(addr);
+    const uint16_t next_upper = uint16_t(uint32_t(addr) >> 16);
+    if (next_upper != upper) {
+      upper = next_upper;
+      uint8_t checksum = print_ihx_header<API>(2, 0, 4) + (upper >> 8) + (upper & 0xFF);
+      format_hex16(API::print_char, upper);
+      format_hex8(API::print_char, -checksum);
+      API::newline();
+    }
 
-    // Print record header
-    API::print_char(':');
-    format_hex8(API::print_char, rec_size);
-    format_hex16(API::print_char, start);
-    format_hex8(API::print_char, 0);
+    // Stop record at end of size or at 64K boundary
+    uint8_t rec_words = size > REC_WORDS ? REC_WORDS : size;
+    uint8_t rec_size = rec_words * LANES;
+    if (uint16_t(offset + rec_size - 1) < offset) {
+      rec_size = -offset;
+      rec_words = rec_size / LANES;
+    }
+    size -= rec_words;
 
     // Print data and checksum
-    uint8_t checksum = rec_size + (start >> 8) + (start & 0xFF);
-    while (rec_size-- > 0) {
-      uint8_t data = API::BUS::read_bus(start++);
-      format_hex8(API::print_char, data);
-      checksum += data;
+    uint8_t checksum = print_ihx_header<API>(rec_size, offset, 0);
+    io::read_block<typename API::BUS>(start, rec_data, rec_words);
+    for (uint8_t i = 0; i < rec_words; ++i) {
+      for (uint8_t lane = 0; lane < LANES; ++lane) {
+        const uint8_t data = rec_data[i] >> (8 * lane);
+        format_hex8(API::print_char, data);
+        checksum += data;
+      }
     }
+    start += rec_words;
+    addr += rec_size;
     format_hex8(API::print_char, -checksum);
     API::newline();
   }
@@ -182,15 +391,19 @@ void impl_export(uint16_t start, uint16_t size) {
 
 template <typename API, uint8_t REC_SIZE = 32>
 void cmd_export(cli::Args args) {
-  CORE_EXPECT_ADDR(API, uint16_t, start, args, return);
-  CORE_EXPECT_UINT(API, uint16_t, size, args, return);
+  CORE_EXPECT_ADDR(API, address_t<API>, start, args, return);
+  CORE_EXPECT_UINT(API, address_t<API>, size, args, return);
   impl_export<API, REC_SIZE>(start, size);
 }
 
 // Parse serial data in IHX format
+// Calls handle_byte(uint32_t address, uint8_t data) for each byte of data
+// records (00), offset by extended segment (02) or linear (04) address records
 template <typename API, typename F>
 bool parse_ihx(F&& handle_byte) {
-  auto parse_loop = [&handle_byte]() {
+  // Base address persists across records until changed by 02 or 04
+  uint32_t base = 0;
+  auto parse_loop = [&handle_byte, &base]() {
     for (;;) {
       // Discard characters while looking for start of record (:)
       for (;;) {
@@ -201,14 +414,19 @@ bool parse_ihx(F&& handle_byte) {
 
       // Parse record header and data
       CORE_INPUT_HEX8(API, rec_size, return false);
-      CORE_INPUT_HEX16(API, address, return false);
+      CORE_INPUT_HEX16(API, offset, return false);
       CORE_INPUT_HEX8(API, rec_type, return false);
-      uint8_t checksum = rec_size + (address >> 8) + (address & 0xFF) + rec_type;
+      uint8_t checksum = rec_size + (offset >> 8) + (offset & 0xFF) + rec_type;
 
-      // Read record data
+      // Pass data bytes to handler, or collect bytes of other record types
+      uint32_t value = 0;
       for (uint8_t i = 0; i < rec_size; ++i) {
         CORE_INPUT_HEX8(API, data, return false);
-        handle_byte(address + i, data);
+        if (rec_type == 0) {
+          handle_byte(base + uint16_t(offset + i), data);
+        } else {
+          value = (value << 8) | data;
+        }
         checksum += data;
       }
 
@@ -216,9 +434,11 @@ bool parse_ihx(F&& handle_byte) {
       CORE_INPUT_HEX8(API, neg_checksum, return false);
       if (uint8_t(checksum + neg_checksum) != 0) return false;
 
-      // Exit successfully if record type is not data (00)
-      if (rec_type > 0) {
-        return true;
+      // Exit successfully on end-of-file (01); ignore start address (03, 05)
+      switch (rec_type) {
+      case 1: return true;
+      case 2: base = value << 4; break;
+      case 4: base = value << 16; break;
       }
     }
   };
@@ -232,33 +452,598 @@ bool parse_ihx(F&& handle_byte) {
   return valid;
 }
 
+// Return true if IHX byte address is within the bus address range; bytes
+// beyond it (e.g. after a large 02 or 04 record) would wrap into low memory
+template <typename API>
+bool ihx_in_range(uint32_t address) {
+  using ADDR = typename API::BUS::ADDRESS_TYPE;
+  return address / sizeof(typename API::BUS::DATA_TYPE) <= ADDR(~ADDR(0));
+}
+
+// Assemble IHX bytes into words of BUS::DATA_TYPE, lowest byte first
+// Words with bytes missing from the stream are merged with the bus contents
+template <typename API>
+class LaneWriter {
+  using ADDR = typename API::BUS::ADDRESS_TYPE;
+  using DATA = typename API::BUS::DATA_TYPE;
+  static const uint8_t LANES = sizeof(DATA);
+  static const uint8_t ALL_LANES = (1 << LANES) - 1;
+
+  io::BlockWriter<typename API::BUS> writer_;
+  uint32_t word_ = 0;
+  DATA data_ = 0;
+  uint8_t lanes_ = 0;
+
+public:
+  void write(uint32_t addr, uint8_t data) {
+    const uint32_t word = addr / LANES;
+    if (lanes_ != 0 && word != word_) {
+      flush_word();
+    }
+    word_ = word;
+    const uint8_t lane = addr % LANES;
+    data_ = (data_ & ~(DATA(0xFF) << (8 * lane))) | (DATA(data) << (8 * lane));
+    lanes_ |= 1 << lane;
+    if (lanes_ == ALL_LANES) {
+      flush_word();
+    }
+  }
+
+  void flush() {
+    if (lanes_ != 0) {
+      flush_word();
+    }
+    writer_.flush();
+  }
+
+private:
+  void flush_word() {
+    if (lanes_ != ALL_LANES) {
+      // Read-modify-write to keep lanes not present in the stream
+      writer_.flush();
+      API::BUS::config_read();
+      const DATA prev = API::BUS::read_bus(ADDR(word_));
+      API::BUS::config_write();
+      DATA keep = 0;
+      for (uint8_t lane = 0; lane < LANES; ++lane) {
+        if ((lanes_ & (1 << lane)) == 0) {
+          keep |= DATA(0xFF) << (8 * lane);
+        }
+      }
+      data_ = (data_ & ~keep) | (prev & keep);
+    }
+    writer_.write(ADDR(word_), data_);
+    data_ = 0;
+    lanes_ = 0;
+  }
+};
+
 // Write IHX stream into memory
 template <typename API>
 void cmd_import(cli::Args) {
+  io::reset_write_stats<typename API::BUS>();
   API::BUS::config_write();
-  bool valid = parse_ihx<API>(API::BUS::write_bus);
+  LaneWriter<API> writer;
+  bool in_range = true;
+  bool valid = parse_ihx<API>([&writer, &in_range](uint32_t address, uint8_t data) {
+    if (ihx_in_range<API>(address)) {
+      writer.write(address, data);
+    } else {
+      in_range = false;
+    }
+  });
+  writer.flush();
   API::newline();
+  CORE_FMT_ERROR(API, !in_range, "addr", "", valid = false);
+  if (!impl_flush<API>()) {
+    valid = false;
+  }
+  print_write_stats<API>();
   API::print_string(valid ? "OK" : "ERROR");
   API::newline();
-  API::BUS::flush_write();
 }
 
 // Validate IHX stream against memory
 template <typename API>
 void cmd_verify(cli::Args) {
+  using DATA = typename API::BUS::DATA_TYPE;
+  constexpr uint8_t LANES = sizeof(DATA);
   API::BUS::config_read();
   bool success = true;
-  bool valid = parse_ihx<API>([&success](uint16_t address, uint8_t data) {
-    if (API::BUS::read_bus(address) != data) {
+  // Keep last word read to compare its other lanes
+  bool cached = false;
+  uint32_t word = 0;
+  DATA value = 0;
+  bool in_range = true;
+  bool valid = parse_ihx<API>([&](uint32_t address, uint8_t data) {
+    if (!ihx_in_range<API>(address)) {
+      in_range = false;
+      return;
+    }
+    if (!cached || address / LANES != word) {
+      word = address / LANES;
+      value = API::BUS::read_bus(word);
+      cached = true;
+    }
+    if (uint8_t(value >> (8 * (address % LANES))) != data) {
       API::print_char('*');
       success = false;
     }
   });
   API::newline();
+  CORE_FMT_ERROR(API, !in_range, "addr", "", valid = false);
   API::print_string(valid ? (success ? "PASS" : "FAIL") : "ERROR");
   API::newline();
 }
 
+// Read [start, start+size) in chunks and pass them to handle(bytes, n)
+// Words wider than 8 bits are split into bytes, lowest byte first
+template <typename API, uint8_t BUF_SIZE = 32, typename F>
+void impl_read_bytes(address_t<API> start, address_t<API> size, F&& handle) {
+  using DATA = typename API::BUS::DATA_TYPE;
+  constexpr uint8_t LANES = sizeof(DATA);
+  DATA buffer[BUF_SIZE];
+  uint8_t bytes[LANES == 1 ? 1 : BUF_SIZE * LANES];
+  API::BUS::config_read();
+  while (size > 0) {
+    uint8_t n = size > BUF_SIZE ? BUF_SIZE : size;
+    io::read_block<typename API::BUS>(start, buffer, n);
+    if (LANES == 1) {
+      handle(reinterpret_cast<const uint8_t*>(buffer), n);
+    } else {
+      for (uint8_t i = 0; i < n; ++i) {
+        for (uint8_t lane = 0; lane < LANES; ++lane) {
+          bytes[i * LANES + lane] = buffer[i] >> (8 * lane);
+        }
+      }
+      handle(bytes, uint16_t(n) * LANES);
+    }
+    start += n;
+    size -= n;
+  }
+}
+
+// Print CRC-16/CCITT-FALSE and CRC-32 of memory range
+template <typename API>
+void cmd_crc(cli::Args args) {
+  CORE_EXPECT_ADDR(API, address_t<API>, start, args, return);
+  CORE_EXPECT_UINT(API, address_t<API>, size, args, return);
+  uint16_t crc16 = CRC16_INIT;
+  uint32_t crc32 = CRC32_INIT;
+  impl_read_bytes<API>(start, size, [&](const uint8_t* bytes, uint16_t n) {
+    crc16 = crc16_update(crc16, bytes, n);
+    crc32 = crc32_update(crc32, bytes, n);
+  });
+  API::print_string("crc16 $");
+  format_hex16(API::print_char, crc16);
+  API::newline();
+  API::print_string("crc32 $");
+  format_hex32(API::print_char, crc32 ^ CRC32_INIT);
+  API::newline();
+}
+
+// Compare memory against host image by block hashes (like rsync)
+// For each block of [start, start+size), the host sends the CRC-32 of its
+// image as $ and 8 hex digits and the device replies '=' if the bus matches or '*'
+// if it differs; the host then sends only the differing blocks with import
+template <typename API>
+void cmd_sync(cli::Args args) {
+  using ADDR = address_t<API>;
+  CORE_EXPECT_ADDR(API, ADDR, start, args, return);
+  CORE_EXPECT_UINT(API, ADDR, size, args, return);
+  CORE_OPTION_UINT(API, ADDR, block, 256, args, return);
+  CORE_FMT_ERROR(API, block == 0, "block", "", return);
+  ADDR differ = 0;
+  bool valid = true;
+  while (size > 0) {
+    const ADDR n = size > block ? block : size;
+    // Discard characters while looking for start of hash ($); hashes are
+    // not echoed, so the host sees only the reply for each block
+    char c;
+    do {
+      c = input_char_quiet<API>();
+    } while (c != '$' && c != '\e');
+    uint32_t expect;
+    if (c == '\e' || !input_hex<API, 8, false>(expect)) {
+      valid = false;
+      break;
+    }
+    uint32_t crc = CRC32_INIT;
+    impl_read_bytes<API>(start, n, [&crc](const uint8_t* bytes, uint16_t len) {
+      crc = crc32_update(crc, bytes, len);
+    });
+    const bool same = (crc ^ CRC32_INIT) == expect;
+    API::print_char(same ? '=' : '*');
+    differ += same ? 0 : 1;
+    start += n;
+    size -= n;
+  }
+  API::newline();
+  if (valid) {
+    API::print_string("differ $");
+    format_hex(API::print_char, differ);
+  } else {
+    API::print_string("ERROR");
+  }
+  API::newline();
+}
+
+template <typename API>
+void print_diff_run(address_t<API> first, address_t<API> last) {
+  API::print_char('$');
+  format_hex(API::print_char, first);
+  API::print_string("-$");
+  format_hex(API::print_char, last);
+  API::print_string(" differ");
+  API::newline();
+}
+
+// Compare [start, start+size) with words from load(offset, buf, n), where
+// offset is relative to start, printing differing addresses as coalesced runs
+// Prints "..." and stops if more than max_runs runs differ; returns the number
+// of runs printed, so max_runs must be at least 1 for 0 to mean no difference
+template <typename API, uint8_t BUF_SIZE = 32, typename F>
+uint16_t impl_diff(address_t<API> start, address_t<API> size, uint16_t max_runs, F&& load) {
+  using ADDR = address_t<API>;
+  using DATA = typename API::BUS::DATA_TYPE;
+  DATA actual[BUF_SIZE];
+  DATA expect[BUF_SIZE];
+  uint16_t runs = 0;
+  bool in_run = false;
+  ADDR run_start = 0;
+  for (ADDR offset = 0; offset < size; ) {
+    const uint8_t n = size - offset > BUF_SIZE ? BUF_SIZE : size - offset;
+    load(offset, expect, n);
+    API::BUS::config_read();
+    io::read_block<typename API::BUS>(start + offset, actual, n);
+    for (uint8_t i = 0; i < n; ++i) {
+      const ADDR addr = start + offset + i;
+      if (actual[i] != expect[i]) {
+        if (!in_run) {
+          if (runs == max_runs) {
+            // Mark that more runs were omitted
+            API::print_string("...");
+            API::newline();
+            return runs;
+          }
+          in_run = true;
+          run_start = addr;
+        }
+      } else if (in_run) {
+        in_run = false;
+        print_diff_run<API>(run_start, addr - 1);
+        ++runs;
+      }
+    }
+    offset += n;
+  }
+  if (in_run) {
+    print_diff_run<API>(run_start, start + size - 1);
+    ++runs;
+  }
+  return runs;
+}
+
+// Compare two memory ranges, printing up to max_runs runs of differences
+template <typename API, uint8_t BUF_SIZE = 32>
+void cmd_compare(cli::Args args) {
+  using ADDR = address_t<API>;
+  CORE_EXPECT_ADDR(API, ADDR, start, args, return);
+  CORE_EXPECT_UINT(API, ADDR, size, args, return);
+  CORE_EXPECT_ADDR(API, ADDR, dest, args, return);
+  CORE_OPTION_UINT(API, uint16_t, max_runs, 16, args, return);
+  CORE_FMT_ERROR(API, max_runs == 0, "max_runs", "", return);
+  uint16_t runs = impl_diff<API, BUF_SIZE>(start, size, max_runs,
+    [dest](ADDR offset, typename API::BUS::DATA_TYPE* buf, uint8_t n) {
+      API::BUS::config_read();
+      io::read_block<typename API::BUS>(dest + offset, buf, n);
+    });
+  if (runs == 0) {
+    API::print_string("same");
+    API::newline();
+  }
+}
+
+// Search [start, start+size) for pattern of len words, calling found(addr)
+// for each match. Uses Boyer-Moore-Horspool skips over a ring buffer of RING
+// words, so each bus word is read once no matter how far the pattern skips.
+template <typename API, uint8_t RING = 64, typename F>
+void impl_find(address_t<API> start, address_t<API> size,
+    const typename API::BUS::DATA_TYPE* pattern, uint8_t len, F&& found) {
+  using ADDR = address_t<API>;
+  using DATA = typename API::BUS::DATA_TYPE;
+  static_assert(util::is_power_of_two(RING), "RING must be a power of two");
+  if (len == 0 || len > RING / 2 || size < len) return;
+
+  // Skip distance keyed by the low byte of the word aligned with the last
+  // pattern word; wider words may share a slot, so keep the smallest skip
+  uint8_t skip[256];
+  for (auto& dist : skip) {
+    dist = len;
+  }
+  for (uint8_t i = 0; i + 1 < len; ++i) {
+    skip[uint8_t(pattern[i])] = len - 1 - i;
+  }
+
+  DATA ring[RING];
+  ADDR filled = 0;
+  API::BUS::config_read();
+  for (ADDR pos = 0; pos <= size - len; ) {
+    // Read ahead until ring covers [pos, pos+len), without overwriting
+    // words at or after pos
+    while (filled < pos + len) {
+      const uint8_t index = filled % RING;
+      ADDR n = RING - (index > len ? index : len);
+      if (n > ADDR(size - filled)) n = size - filled;
+      io::read_block<typename API::BUS>(start + filled, ring + index, n);
+      filled += n;
+    }
+
+    // Compare from last word to first
+    uint8_t i = len;
+    while (i > 0 && ring[(pos + i - 1) % RING] == pattern[i - 1]) {
+      --i;
+    }
+    if (i == 0) {
+      found(ADDR(start + pos));
+    }
+    pos += skip[uint8_t(ring[(pos + len - 1) % RING])];
+  }
+}
+
+// Search memory for pattern of words and strings, as taken by cmd_set
+template <typename API, uint8_t MAX_SIZE = 16>
+void cmd_find(cli::Args args) {
+  using ADDR = address_t<API>;
+  using DATA = typename API::BUS::DATA_TYPE;
+  CORE_EXPECT_ADDR(API, ADDR, start, args, return);
+  CORE_EXPECT_UINT(API, ADDR, size, args, return);
+  DATA pattern[MAX_SIZE];
+  uint8_t len = 0;
+  do {
+    if (args.is_string()) {
+      for (const char* str = args.next(); *str != '\0'; ++str) {
+        CORE_FMT_ERROR(API, len == MAX_SIZE, "pattern", "", return);
+        pattern[len++] = *str;
+      }
+    } else {
+      CORE_FMT_ERROR(API, len == MAX_SIZE, "pattern", "", return);
+      CORE_EXPECT_UINT(API, DATA, data, args, return);
+      pattern[len++] = data;
+    }
+  } while (args.has_next());
+  CORE_FMT_ERROR(API, len == 0, "pattern", "", return);
+
+  impl_find<API, MAX_SIZE * 2>(start, size, pattern, len, [](ADDR addr) {
+    API::print_char('$');
+    format_hex(API::print_char, addr);
+    // If address has label, print it
+    const char* label;
+    if (addr <= 0xFFFF && API::get_labels().get_name(addr, label)) {
+      API::print_char(' ');
+      API::print_string(label);
+    }
+    API::newline();
+  });
+}
+
+// Read [start, start+size) in blocks and pass each word to check(addr, expect, actual)
+template <typename API, uint8_t BUF_SIZE = 32, typename F>
+void impl_test_verify(address_t<API> start, address_t<API> size,
+    typename API::BUS::DATA_TYPE expect, F&& check) {
+  using ADDR = address_t<API>;
+  typename API::BUS::DATA_TYPE buffer[BUF_SIZE];
+  API::BUS::config_read();
+  for (ADDR offset = 0; offset < size; ) {
+    const uint8_t n = size - offset > BUF_SIZE ? BUF_SIZE : size - offset;
+    io::read_block<typename API::BUS>(start + offset, buffer, n);
+    for (uint8_t i = 0; i < n; ++i) {
+      check(ADDR(start + offset + i), expect, buffer[i]);
+    }
+    offset += n;
+  }
+}
+
+// March element: at each address in turn, read and check expect, then write
+template <typename API, typename F>
+void impl_test_march(address_t<API> start, address_t<API> size, bool down,
+    typename API::BUS::DATA_TYPE expect, typename API::BUS::DATA_TYPE write, F&& check) {
+  using ADDR = address_t<API>;
+  for (ADDR i = 0; i < size; ++i) {
+    const ADDR addr = down ? start + (size - 1 - i) : start + i;
+    API::BUS::config_read();
+    check(addr, expect, API::BUS::read_bus(addr));
+    API::BUS::config_write();
+    API::BUS::write_bus(addr, write);
+  }
+  API::BUS::flush_write();
+}
+
+// Run March C- and walking ones over [start, start+size), passing each word
+// read to check(addr, expect, actual); returns number of bytes transferred
+template <typename API, typename F>
+uint32_t impl_test(address_t<API> start, address_t<API> size, F&& check) {
+  using DATA = typename API::BUS::DATA_TYPE;
+  constexpr uint8_t BITS = sizeof(DATA) * 8;
+  const DATA ONES = DATA(~DATA(0));
+  const address_t<API> end = start + size - 1;
+
+  // March C-: {any(w0); up(r0,w1); up(r1,w0); down(r0,w1); down(r1,w0); any(r0)}
+  API::BUS::config_write();
+  impl_memset<API>(start, end, 0);
+  API::BUS::flush_write();
+  impl_test_march<API>(start, size, false, 0, ONES, check);
+  impl_test_march<API>(start, size, false, ONES, 0, check);
+  impl_test_march<API>(start, size, true, 0, ONES, check);
+  impl_test_march<API>(start, size, true, ONES, 0, check);
+  impl_test_verify<API>(start, size, 0, check);
+
+  // Walking ones to find shorted or open data lines
+  for (uint8_t bit = 0; bit < BITS; ++bit) {
+    const DATA pattern = DATA(1) << bit;
+    API::BUS::config_write();
+    impl_memset<API>(start, end, pattern);
+    API::BUS::flush_write();
+    impl_test_verify<API>(start, size, pattern, check);
+  }
+
+  // March C- makes 10 accesses per word, walking ones 2 per bit
+  return uint32_t(size) * sizeof(DATA) * (10 + 2 * BITS);
+}
+
+// Return a * b / c, rounded down, for a < c without 64-bit math
+// Builds the product one bit of b at a time, keeping the remainder below c
+inline uint32_t mul_div_fraction(uint32_t a, uint16_t b, uint32_t c) {
+  uint32_t quot = 0;
+  uint32_t rem = 0;
+  for (uint16_t bit = 0x8000; bit != 0; bit >>= 1) {
+    quot <<= 1;
+    if (rem >= c - rem) {
+      rem -= c - rem;
+      ++quot;
+    } else {
+      rem += rem;
+    }
+    if (b & bit) {
+      if (rem >= c - a) {
+        rem -= c - a;
+        ++quot;
+      } else {
+        rem += a;
+      }
+    }
+  }
+  return quot;
+}
+
+// Test memory, printing up to MAX_FAILS failing addresses with the bits that
+// differ, then the total failures, elapsed time, and throughput
+template <typename API, uint8_t MAX_FAILS = 8>
+void cmd_test(cli::Args args) {
+  using ADDR = address_t<API>;
+  using DATA = typename API::BUS::DATA_TYPE;
+  CORE_EXPECT_ADDR(API, ADDR, start, args, return);
+  CORE_EXPECT_UINT(API, ADDR, size, args, return);
+  CORE_FMT_ERROR(API, size == 0, "size", "", return);
+  uint32_t fails = 0;
+  DATA bits = 0;
+  const uint32_t begin = millis();
+  const uint32_t bytes = impl_test<API>(start, size, [&](ADDR addr, DATA expect, DATA actual) {
+    if (actual != expect) {
+      if (fails < MAX_FAILS) {
+        API::print_char('$');
+        format_hex(API::print_char, addr);
+        API::print_string(" $");
+        format_hex(API::print_char, DATA(actual ^ expect));
+        API::newline();
+      }
+      ++fails;
+      bits |= actual ^ expect;
+    }
+  });
+  const uint32_t elapsed = millis() - begin;
+
+  if (fails > 0) {
+    API::print_string("FAIL $");
+    format_hex32(API::print_char, fails);
+    API::print_string(" bits $");
+    format_hex(API::print_char, bits);
+  } else {
+    API::print_string("PASS");
+  }
+  API::newline();
+  API::print_string("ms ");
+  format_dec(API::print_char, elapsed);
+  if (elapsed > 0) {
+    API::print_string(" B/s ");
+    // Scale quotient and remainder separately to avoid 64-bit division on AVR
+    format_dec(API::print_char, bytes / elapsed * 1000
+      + mul_div_fraction(bytes % elapsed, 1000, elapsed));
+  }
+  API::newline();
+}
+
+// Memory range captured by cmd_snap for cmd_delta
+template <typename API, uint16_t SIZE>
+struct Snapshot {
+  static address_t<API> start;
+  static address_t<API> size;
+  static typename API::BUS::DATA_TYPE data[SIZE];
+};
+
+template <typename API, uint16_t SIZE>
+address_t<API> Snapshot<API, SIZE>::start;
+
+template <typename API, uint16_t SIZE>
+address_t<API> Snapshot<API, SIZE>::size;
+
+template <typename API, uint16_t SIZE>
+typename API::BUS::DATA_TYPE Snapshot<API, SIZE>::data[SIZE];
+
+// Copy memory range into snapshot of up to SIZE words
+template <typename API, uint16_t SIZE = 256>
+void cmd_snap(cli::Args args) {
+  using SNAP = Snapshot<API, SIZE>;
+  CORE_EXPECT_ADDR(API, address_t<API>, start, args, return);
+  CORE_EXPECT_UINT(API, address_t<API>, size, args, return);
+  CORE_FMT_ERROR(API, size == 0 || size > SIZE, "size", "", return);
+  API::BUS::config_read();
+  io::read_block<typename API::BUS>(start, SNAP::data, size);
+  SNAP::start = start;
+  SNAP::size = size;
+}
+
+// Compare memory with snapshot, printing up to max_runs runs of changes
+template <typename API, uint16_t SIZE = 256, uint8_t BUF_SIZE = 32>
+void cmd_delta(cli::Args args) {
+  using ADDR = address_t<API>;
+  using DATA = typename API::BUS::DATA_TYPE;
+  using SNAP = Snapshot<API, SIZE>;
+  CORE_OPTION_UINT(API, uint16_t, max_runs, 16, args, return);
+  CORE_FMT_ERROR(API, max_runs == 0, "max_runs", "", return);
+  CORE_FMT_ERROR(API, SNAP::size == 0, "snap", "", return);
+  uint16_t runs = impl_diff<API, BUF_SIZE>(SNAP::start, SNAP::size, max_runs,
+    [](ADDR offset, DATA* buf, uint8_t n) {
+      memcpy(buf, SNAP::data + offset, n * sizeof(DATA));
+    });
+  if (runs == 0) {
+    API::print_string("same");
+    API::newline();
+  }
+}
+
+// Print bus traffic counted by io::CountingBus since the last call, then reset
+template <typename API>
+void cmd_count(cli::Args) {
+  using BUS = typename API::BUS;
+  const io::BusCounts& counts = BUS::counts();
+  const char* const names[] = {
+    "read", "write", "cfg_read", "cfg_write", "cfg_float", "flush" };
+  const uint32_t values[] = {
+    counts.reads, counts.writes, counts.config_reads,
+    counts.config_writes, counts.config_floats, counts.flushes };
+  for (uint8_t i = 0; i < 6; ++i) {
+    API::print_string(names[i]);
+    API::print_string(" $");
+    format_hex32(API::print_char, values[i]);
+    API::newline();
+  }
+
+  // Print non-empty address bins
+  for (uint8_t i = 0; i < BUS::BIN_COUNT; ++i) {
+    uint32_t count = BUS::bin_count(i);
+    if (count > 0) {
+      const typename BUS::ADDRESS_TYPE addr = typename BUS::ADDRESS_TYPE(i) << BUS::BIN_SHIFT;
+      API::print_string(" $");
+      format_hex(API::print_char, addr);
+      API::print_string(" $");
+      format_hex32(API::print_char, count);
+      API::newline();
+    }
+  }
+  BUS::reset();
+}
+
 template <typename API>
 void cmd_label(cli::Args args) {
   auto& labels = API::get_labels();
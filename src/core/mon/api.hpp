@@ -32,6 +32,21 @@ struct Base {
     return c;
   }
 
+  // Get input character if one is available, without waiting or echoing
+  static bool try_input_char(char& c) {
+    if (T::get_stream().available() == 0) return false;
+    c = T::get_stream().read();
+    return true;
+  }
+
+  // Free space in output buffer; stream must implement availableForWrite
+  static int available_for_write() { return T::get_stream().availableForWrite(); }
+
+  static void save_cursor() { T::get_stream().save_cursor(); }
+  static void restore_cursor() { T::get_stream().restore_cursor(); }
+  static void cursor_up(uint8_t spaces) { T::get_stream().cursor_up(spaces); }
+  static void cursor_right(uint8_t spaces) { T::get_stream().cursor_right(spaces); }
+
   static void prompt_char(char c) { T::get_cli().prefix(c); }
   static void prompt_string(const char* str) { T::get_cli().prefix(str); }
 
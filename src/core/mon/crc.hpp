@@ -0,0 +1,96 @@
+// Copyright (c) 2023 Trevor Makes
+
+#pragma once
+
+#include "core/arduino.hpp"
+#include "core/util.hpp"
+
+#include <stdint.h>
+
+namespace core {
+namespace mon {
+
+// CRC-16/CCITT-FALSE: poly 0x1021, init 0xFFFF, not reflected, no final xor
+constexpr uint16_t CRC16_INIT = 0xFFFF;
+// CRC-32 (zlib): reflected poly 0xEDB88320, init and final xor 0xFFFFFFFF
+constexpr uint32_t CRC32_INIT = 0xFFFFFFFF;
+
+// Shift 8 bits through the CRC-16 register
+constexpr uint16_t crc16_entry(uint16_t crc, uint8_t bits = 8) {
+  return bits == 0 ? crc : crc16_entry(
+    (crc & 0x8000) ? uint16_t((crc << 1) ^ 0x1021) : uint16_t(crc << 1), bits - 1);
+}
+
+// Shift 8 bits through the CRC-32 register
+constexpr uint32_t crc32_entry(uint32_t crc, uint8_t bits = 8) {
+  return bits == 0 ? crc : crc32_entry(
+    (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1, bits - 1);
+}
+
+// Slicing-by-N table j holds the CRC of byte i followed by j zero bytes
+constexpr uint32_t crc32_slice(uint8_t j, uint32_t crc) {
+  return j == 0 ? crc : crc32_slice(j - 1, (crc >> 8) ^ crc32_entry(crc & 0xFF));
+}
+
+#ifdef __AVR_ARCH__
+// One 1 KB table in PROGMEM
+constexpr uint8_t CRC32_SLICES = 1;
+#else
+// Eight tables (8 KB) to process 8 bytes per step
+constexpr uint8_t CRC32_SLICES = 8;
+#endif
+
+template <typename SEQ16, typename SEQ32>
+struct CrcTables;
+
+template <uint16_t... I, uint16_t... J>
+struct CrcTables<util::index_sequence<I...>, util::index_sequence<J...>> {
+  static const uint16_t CRC16[sizeof...(I)];
+  static const uint32_t CRC32[sizeof...(J)];
+};
+
+template <uint16_t... I, uint16_t... J>
+const uint16_t CrcTables<util::index_sequence<I...>, util::index_sequence<J...>>::CRC16[sizeof...(I)] PROGMEM = {
+  crc16_entry(uint16_t(I << 8))... };
+
+template <uint16_t... I, uint16_t... J>
+const uint32_t CrcTables<util::index_sequence<I...>, util::index_sequence<J...>>::CRC32[sizeof...(J)] PROGMEM = {
+  crc32_slice(J / 256, crc32_entry(J % 256))... };
+
+using CRC_TABLES = CrcTables<util::make_index_sequence<256>, util::make_index_sequence<256 * CRC32_SLICES>>;
+
+// Update CRC-16 register with n bytes
+inline uint16_t crc16_update(uint16_t crc, const uint8_t* data, uint16_t n) {
+  for (uint16_t i = 0; i < n; ++i) {
+    crc = (crc << 8) ^ pgm_read_word(CRC_TABLES::CRC16 + ((crc >> 8) ^ data[i]));
+  }
+  return crc;
+}
+
+inline uint32_t crc32_table(uint8_t slice, uint8_t index) {
+  return pgm_read_dword(CRC_TABLES::CRC32 + slice * 256 + index);
+}
+
+// Update CRC-32 register with n bytes; xor result with CRC32_INIT when done
+inline uint32_t crc32_update(uint32_t crc, const uint8_t* data, uint16_t n) {
+#ifndef __AVR_ARCH__
+  // Slicing-by-8: fold 8 bytes per step with independent table lookups
+  for (; n >= 8; n -= 8, data += 8) {
+    const uint32_t lo = crc ^ (uint32_t(data[0]) | uint32_t(data[1]) << 8
+      | uint32_t(data[2]) << 16 | uint32_t(data[3]) << 24);
+    const uint32_t hi = uint32_t(data[4]) | uint32_t(data[5]) << 8
+      | uint32_t(data[6]) << 16 | uint32_t(data[7]) << 24;
+    crc = crc32_table(7, lo) ^ crc32_table(6, lo >> 8)
+      ^ crc32_table(5, lo >> 16) ^ crc32_table(4, lo >> 24)
+      ^ crc32_table(3, hi) ^ crc32_table(2, hi >> 8)
+      ^ crc32_table(1, hi >> 16) ^ crc32_table(0, hi >> 24);
+  }
+#endif
+  for (uint16_t i = 0; i < n; ++i) {
+    crc = (crc >> 8) ^ crc32_table(0, uint8_t(crc ^ data[i]));
+  }
+  return crc;
+}
+
+} // namespace mon
+} // namespace core
@@ -27,12 +27,32 @@ bool parse_unsigned(T& result, const char* str) {
   return end != str && *end == '\0';
 }
 
-template <typename API, uint8_t N, typename T>
+// Wait for next input character without echoing it
+template <typename API>
+char input_char_quiet() {
+  char c;
+  while (!API::try_input_char(c)) {}
+  return c;
+}
+
+// Select input_hex reader at compile time, so APIs without try_input_char
+// can still use the echoing reader
+template <bool ECHO>
+struct EchoTag {};
+
+template <typename API>
+char input_hex_char(EchoTag<true>) { return API::input_char(); }
+
+template <typename API>
+char input_hex_char(EchoTag<false>) { return input_char_quiet<API>(); }
+
+// Read N hex digits; set ECHO false for machine input such as hashes
+template <typename API, uint8_t N, bool ECHO = true, typename T>
 bool input_hex(T& result) {
   // NOTE previously used strtoul, but it was much slower
   T value = 0;
   for (uint8_t i = N; i > 0; --i) {
-    char c = API::input_char();
+    char c = input_hex_char<API>(EchoTag<ECHO>());
     value <<= 4;
     if (c >= '0' && c <= '9') {
       value |= c - '0';
@@ -84,6 +104,20 @@ void format_hex(F&& print, uint32_t n) {
 template <typename F>
 void format_hex32(F&& print, uint32_t n) { format_hex(print, n); }
 
+// Print decimal digits without leading zeroes
+template <typename F>
+void format_dec(F&& print, uint32_t n) {
+  char digits[10];
+  uint8_t i = 0;
+  do {
+    digits[i++] = '0' + n % 10;
+    n /= 10;
+  } while (n > 0);
+  while (i > 0) {
+    print(digits[--i]);
+  }
+}
+
 // Print 8 binary digits with leading zeroes
 template <typename F>
 void format_bin8(F&& print, uint8_t n) {
@@ -133,6 +167,29 @@ void set_prompt(const char* cmd, const T arg, const Var... var)
   }
 }
 
+// Call before each row of streamed output to apply flow control
+// Returns false on escape; pauses from XOFF until XON; waits until the output
+// buffer has room for MIN_FREE characters, watching for input meanwhile
+// A free count of 0 is taken as unknown, as Stream::availableForWrite returns
+// 0 unless overridden; output then blocks in print instead
+template <typename API, uint8_t MIN_FREE = 16>
+bool stream_ready() {
+  constexpr char XON = 0x11;
+  constexpr char XOFF = 0x13;
+  bool paused = false;
+  for (;;) {
+    char c;
+    if (API::try_input_char(c)) {
+      if (c == '\e') return false;
+      if (c == XOFF) paused = true;
+      if (c == XON) paused = false;
+    } else if (!paused) {
+      const int free = API::available_for_write();
+      if (free == 0 || free >= MIN_FREE) return true;
+    }
+  }
+}
+
 template <typename API>
 void print_pgm_string(const char* str) {
   for (;;) {
@@ -34,6 +34,15 @@ public:
 
   bool get_index(uint8_t index, const char*& name, uint16_t& addr) const;
   bool get_addr(const char* name, uint16_t& addr) const;
+
+  // Labels hold 16-bit addresses; widen for buses with wider ADDRESS_TYPE
+  template <typename T>
+  bool get_addr(const char* name, T& addr) const {
+    uint16_t addr16;
+    if (!get_addr(name, addr16)) return false;
+    addr = addr16;
+    return true;
+  }
   bool get_name(uint16_t addr, const char*& name) const;
 
   bool remove_label(const char* name);
@@ -5,6 +5,7 @@
 #include "z80/asm.hpp"
 #include "z80/dasm.hpp"
 #include "core/cli.hpp"
+#include "core/mon.hpp"
 
 namespace core {
 namespace mon {
@@ -85,13 +86,14 @@ void cmd_asm(cli::Args args) {
   if (parse_instruction<API>(inst, args)) {
     API::BUS::config_write();
     uint8_t size = asm_instruction<API>(inst, start);
-    API::BUS::flush_write();
-    if (size > 0) {
-      set_prompt<API>(args.command(), start + size);
+    if (impl_flush<API>() && size > 0) {
+      set_prompt<API>(args.command(), uint16_t(start + size));
     }
   }
 }
 
+// If MAX_ROWS is 0, stream the whole range with flow control instead of
+// stopping with a continuation prompt
 template <typename API, uint8_t MAX_ROWS = 24>
 void cmd_dasm(cli::Args args) {
   // Default size to one instruction if not provided
@@ -99,10 +101,19 @@ void cmd_dasm(cli::Args args) {
   CORE_OPTION_UINT(API, uint16_t, size, 1, args, return);
   API::BUS::config_read();
   uint16_t end_incl = start + size - 1;
+  if (MAX_ROWS == 0) {
+    for (uint16_t addr = start; stream_ready<API>(); ) {
+      uint16_t next = dasm_range<API, 1>(addr, end_incl);
+      // Stop when end does not overlap with next instruction
+      if (uint16_t(end_incl - addr) < uint16_t(next - addr)) break;
+      addr = next;
+    }
+    return;
+  }
   uint16_t next = dasm_range<API, MAX_ROWS>(start, end_incl);
   uint16_t part = next - start;
   if (part < size) {
-    set_prompt<API>(args.command(), next, size - part);
+    set_prompt<API>(args.command(), next, uint16_t(size - part));
   } else {
     set_prompt<API>(args.command(), next);
   }
@@ -17,6 +17,8 @@
 #define F(x) (x)
 
 #define pgm_read_byte(ptr) (*(ptr))
+#define pgm_read_word(ptr) (*(ptr))
+#define pgm_read_dword(ptr) (*(ptr))
 #define pgm_read_ptr(ptr) (*(ptr))
 
 #define strcmp_P strcmp
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <chrono>
+
+// Minimal copy of Arduino timing functions for native unit testing
+inline unsigned long millis() {
+  using namespace std::chrono;
+  static const steady_clock::time_point start = steady_clock::now();
+  return duration_cast<milliseconds>(steady_clock::now() - start).count();
+}
+
+inline unsigned long micros() {
+  using namespace std::chrono;
+  static const steady_clock::time_point start = steady_clock::now();
+  return duration_cast<microseconds>(steady_clock::now() - start).count();
+}
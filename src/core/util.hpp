@@ -74,6 +74,55 @@ static_assert(is_same<volatile float&, float>::value == false, "");
 static_assert(is_same<remove_reference<float&>::type, float>::value == true, "");
 static_assert(is_same<remove_volatile_reference<volatile float&>::type, float>::value == true, "");
 
+// C++11 <type_traits>, missing on AVR
+template <bool B, typename T, typename F>
+struct conditional {
+  using type = T;
+};
+
+template <typename T, typename F>
+struct conditional<false, T, F> {
+  using type = F;
+};
+
+static_assert(is_same<conditional<true, int, float>::type, int>::value == true, "");
+static_assert(is_same<conditional<false, int, float>::type, float>::value == true, "");
+
+// C++14 <utility>, missing on AVR
+template <uint16_t... I>
+struct index_sequence {};
+
+template <typename A, typename B>
+struct concat_index_sequence;
+
+template <uint16_t... A, uint16_t... B>
+struct concat_index_sequence<index_sequence<A...>, index_sequence<B...>> {
+  using type = index_sequence<A..., (sizeof...(A) + B)...>;
+};
+
+// Split in halves to keep template recursion depth at log2(N)
+template <uint16_t N>
+struct make_index_sequence_impl {
+  using type = typename concat_index_sequence<
+    typename make_index_sequence_impl<N / 2>::type,
+    typename make_index_sequence_impl<N - N / 2>::type>::type;
+};
+
+template <>
+struct make_index_sequence_impl<0> {
+  using type = index_sequence<>;
+};
+
+template <>
+struct make_index_sequence_impl<1> {
+  using type = index_sequence<0>;
+};
+
+template <uint16_t N>
+using make_index_sequence = typename make_index_sequence_impl<N>::type;
+
+static_assert(is_same<make_index_sequence<3>, index_sequence<0, 1, 2>>::value == true, "");
+
 // Get unsigned type with doubled word size
 template <typename>
 struct extend_unsigned;
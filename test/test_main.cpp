@@ -1,9 +1,15 @@
 #include "core/mon/z80.hpp"
 #include "core/mon/api.hpp"
+#include "core/mon.hpp"
 #include "core/io/bus.hpp"
+#include "core/io/mmap.hpp"
+#include "core/io.hpp"
 
 #include <unity.h>
 
+#include <stdlib.h>
+#include <unistd.h>
+
 using namespace core::mon::z80;
 using namespace core::cli;
 
@@ -339,6 +345,887 @@ void test_str_sort() {
   assert_sorted(TOK_STR);
 }
 
+uint8_t block_data[64];
+using BlockBus = CORE_ARRAY_BUS(block_data, uint16_t);
+
+// Bus without block API to exercise read_bus/write_bus fallback
+struct ByteBus : core::io::BaseBus {
+  using DATA_TYPE = uint8_t;
+  using ADDRESS_TYPE = uint16_t;
+  static void config_write() {}
+  static void config_read() {}
+  static void config_float() {}
+  static DATA_TYPE read_bus(ADDRESS_TYPE addr) { return BlockBus::read_bus(addr); }
+  static void write_bus(ADDRESS_TYPE addr, DATA_TYPE data) { BlockBus::write_bus(addr, data); }
+};
+
+void test_bus_block() {
+  uint8_t out[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+  uint8_t in[8];
+  // Block transfer should wrap around the end of the array
+  core::io::write_block<BlockBus>(60, out, 8);
+  TEST_ASSERT_EQUAL(8, block_data[3]);
+  core::io::read_block<ByteBus>(60, in, 8);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(out, in, 8);
+
+  // BlockWriter should split non-sequential writes into separate blocks
+  core::io::BlockWriter<ByteBus, 4> writer;
+  for (uint8_t i = 0; i < 6; ++i) writer.write(10 + i, i);
+  writer.write(30, 0xAA);
+  writer.flush();
+  core::io::read_block<BlockBus>(10, in, 6);
+  for (uint8_t i = 0; i < 6; ++i) TEST_ASSERT_EQUAL(i, in[i]);
+  TEST_ASSERT_EQUAL(0xAA, block_data[30]);
+}
+
+void test_bus_page_write() {
+  using PageBus = core::io::PageWriteBus<BlockBus, 8>;
+  block_data[17] = 0;
+  PageBus::config_write();
+  PageBus::write_bus(16, 0x11);
+  PageBus::write_bus(17, 0x22);
+  // Writes are held until the page changes or is flushed
+  TEST_ASSERT_EQUAL(0, block_data[17]);
+  TEST_ASSERT_EQUAL(0x22, PageBus::read_bus(17));
+  PageBus::write_bus(24, 0x33);
+  TEST_ASSERT_EQUAL(0x11, block_data[16]);
+  TEST_ASSERT_EQUAL(0x22, block_data[17]);
+  PageBus::flush_write();
+  TEST_ASSERT_EQUAL(0x33, block_data[24]);
+}
+
+// Bus where writes never take effect, as when no device is present
+struct DeadBus : core::io::BaseBus {
+  using DATA_TYPE = uint8_t;
+  using ADDRESS_TYPE = uint16_t;
+  static void config_write() {}
+  static void config_read() {}
+  static void config_float() {}
+  static DATA_TYPE read_bus(ADDRESS_TYPE) { return 0xFF; }
+  static void write_bus(ADDRESS_TYPE, DATA_TYPE) {}
+};
+
+void test_bus_page_write_fail() {
+  using PageBus = core::io::PageWriteBus<DeadBus, 8>;
+  PageBus::config_write();
+  PageBus::write_bus(0, 0x12);
+  PageBus::flush_write();
+  // Poll times out; error is reported once through wrappers
+  TEST_ASSERT_TRUE(core::io::write_failed<core::io::CachedDirectionBus<PageBus>>());
+  TEST_ASSERT_FALSE(core::io::write_failed<PageBus>());
+  TEST_ASSERT_FALSE(core::io::write_failed<BlockBus>());
+}
+
+struct BlockAPI : public core::mon::Base<BlockAPI> {
+  static void print_char(char c) { test_io.try_insert(c); }
+  static void print_string(const char* str) { test_io.try_insert(str); }
+  static void newline() { test_io.try_insert('\n'); }
+
+  using BUS = BlockBus;
+
+  static void prompt_char(char c) { }
+  static void prompt_string(const char* str) { }
+};
+
+void test_memmove() {
+  for (uint8_t i = 0; i < 64; ++i) block_data[i] = i;
+  // Overlapping move up must copy in reverse, across multiple chunks
+  core::mon::impl_memmove<BlockAPI, 4>(0, 9, 3);
+  for (uint8_t i = 0; i < 10; ++i) TEST_ASSERT_EQUAL(i, block_data[3 + i]);
+  // Overlapping move down must copy forward
+  core::mon::impl_memmove<BlockAPI, 4>(3, 12, 1);
+  for (uint8_t i = 0; i < 10; ++i) TEST_ASSERT_EQUAL(i, block_data[1 + i]);
+}
+
+// Port that records its value and number of writes
+template <uint8_t ID>
+struct CountPort {
+  using TYPE = uint8_t;
+  static const TYPE MASK = 0xFF;
+  static uint8_t value;
+  static uint16_t writes;
+  static void write(TYPE data) { value = data; ++writes; }
+  static TYPE read() { return value; }
+  static void config_output() {}
+  static void config_input() {}
+};
+
+template <uint8_t ID> uint8_t CountPort<ID>::value;
+template <uint8_t ID> uint16_t CountPort<ID>::writes;
+
+void test_bus_sequential() {
+  using MSB = CountPort<0>;
+  using LSB = CountPort<1>;
+  using Strobe = core::io::ActiveLow<core::io::PortNull<>>;
+  using Bus = core::io::PortBus<core::io::WordExtend<MSB, LSB>, CountPort<2>, Strobe, Strobe>;
+  uint8_t buf[0x20];
+  MSB::writes = LSB::writes = 0;
+  Bus::read_block(0x12F0, buf, 0x20);
+  // Seek writes both ports; carry from $12FF to $1300 writes MSB once more
+  TEST_ASSERT_EQUAL(2, MSB::writes);
+  TEST_ASSERT_EQUAL(0x21, LSB::writes);
+  TEST_ASSERT_EQUAL(0x13, MSB::value);
+  TEST_ASSERT_EQUAL(0x10, LSB::value);
+}
+
+using SeqBus = core::io::PortBus<core::io::WordExtend<CountPort<0>, CountPort<1>>,
+  CountPort<2>, core::io::ActiveLow<core::io::PortNull<>>, core::io::ActiveLow<core::io::PortNull<>>>;
+
+// Derived bus with its own read_bus, as for a latched address
+struct LatchedBus : SeqBus {
+  static DATA_TYPE read_bus(ADDRESS_TYPE addr) { return uint8_t(addr) ^ 0x5A; }
+  static void write_bus(ADDRESS_TYPE addr, DATA_TYPE data) { block_data[addr % 64] = data; }
+};
+
+// Derived bus that keeps the inherited block methods
+struct SeekBus : SeqBus {
+  using BLOCK_BUS = SeekBus;
+};
+
+void test_bus_derived() {
+  uint8_t buf[4];
+  core::io::read_block<LatchedBus>(0x1230, buf, 4);
+  for (uint8_t i = 0; i < 4; ++i) TEST_ASSERT_EQUAL((0x30 + i) ^ 0x5A, buf[i]);
+  const uint8_t data[2] = { 0xC1, 0xC2 };
+  core::io::write_block<LatchedBus>(6, data, 2);
+  TEST_ASSERT_EQUAL(0xC2, block_data[7]);
+  // Block path seeks once, so MSB is written once rather than per word
+  CountPort<0>::writes = 0;
+  core::io::read_block<SeekBus>(0x12F0, buf, 4);
+  TEST_ASSERT_EQUAL(1, CountPort<0>::writes);
+}
+
+void test_bus_mux() {
+  using Data = CountPort<3>;
+  using Strobe = core::io::ActiveLow<core::io::PortNull<>>;
+  using Latch = core::io::Latch<Data, Strobe>;
+  using Bus = core::io::MuxBus<Data, Latch, Latch, Strobe, Strobe>;
+  Bus::config_write();
+  Data::writes = 0;
+  Bus::write_bus(0x12FE, 0xAA);
+  Bus::write_bus(0x12FF, 0xBB);
+  Bus::write_bus(0x1300, 0xCC);
+  // MSB latched on first access and on crossing to $13xx; LSB and data every access
+  TEST_ASSERT_EQUAL(8, Data::writes);
+  Bus::config_float();
+  Data::writes = 0;
+  Bus::read_bus(0x1301);
+  TEST_ASSERT_EQUAL(2, Data::writes);
+}
+
+template <uint8_t ID>
+struct CountEnable {
+  static uint16_t pulses;
+  static void config_output() {}
+  static void config_input() {}
+  static void enable() { ++pulses; }
+  static void disable() {}
+};
+
+template <uint8_t ID> uint16_t CountEnable<ID>::pulses;
+
+void test_latch_bank() {
+  using Data = CountPort<4>;
+  using Bank = core::io::LatchBank<Data, CountEnable<0>, CountEnable<1>, CountEnable<2>>;
+  Bank::set(0, 0x11);
+  Bank::set(1, 0x22);
+  Bank::set(2, 0x22);
+  Bank::refresh();
+  TEST_ASSERT_EQUAL(1, CountEnable<2>::pulses);
+  // Latches 1 and 2 share a value, so DATA is written once for both
+  TEST_ASSERT_EQUAL(2, Data::writes);
+  Bank::set(0, 0x11);
+  Bank::set(2, 0x33);
+  Bank::commit();
+  // Only latch 2 changed
+  TEST_ASSERT_EQUAL(1, CountEnable<0>::pulses);
+  TEST_ASSERT_EQUAL(1, CountEnable<1>::pulses);
+  TEST_ASSERT_EQUAL(2, CountEnable<2>::pulses);
+  TEST_ASSERT_EQUAL(3, Data::writes);
+  TEST_ASSERT_EQUAL(0x33, Data::value);
+}
+
+void test_bus_banked() {
+  using Bank = CountPort<5>;
+  // 16-word window over block_data
+  using Bus = core::io::BankedBus<BlockBus, Bank, 4>;
+  for (uint8_t i = 0; i < 64; ++i) block_data[i] = i;
+  uint8_t buf[8];
+  Bank::writes = 0;
+  Bus::read_block(0x3001C, buf, 8);
+  // Bank $3001 then $3002; offsets restart at start of window
+  TEST_ASSERT_EQUAL(2, Bank::writes);
+  TEST_ASSERT_EQUAL(0x02, Bank::value);
+  const uint8_t expect[8] = { 12, 13, 14, 15, 0, 1, 2, 3 };
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expect, buf, 8);
+  Bus::read_bus(0x30025);
+  TEST_ASSERT_EQUAL(2, Bank::writes);
+}
+
+void test_bus_cached_direction() {
+  using Counter = core::io::CountingBus<BlockBus>;
+  using Bus = core::io::CachedDirectionBus<Counter>;
+  Counter::reset();
+  Bus::invalidate();
+  TEST_ASSERT_TRUE(Bus::mode() == core::io::BusMode::UNKNOWN);
+  Bus::config_write();
+  Bus::config_write();
+  Bus::config_float();
+  Bus::config_float();
+  Bus::config_write();
+  TEST_ASSERT_TRUE(Bus::mode() == core::io::BusMode::WRITE);
+  // Only changes of direction reach the device
+  TEST_ASSERT_EQUAL(2, Counter::counts().config_writes);
+  TEST_ASSERT_EQUAL(1, Counter::counts().config_floats);
+  // After invalidate, the next call goes through even in the same mode
+  Bus::invalidate();
+  Bus::config_write();
+  TEST_ASSERT_EQUAL(3, Counter::counts().config_writes);
+  TEST_ASSERT_EQUAL(0, Counter::counts().config_reads);
+}
+
+void test_bus_counting() {
+  using Counter = core::io::CountingBus<BlockBus, 4>;
+  using Bus = core::io::CachedDirectionBus<Counter>;
+  uint8_t buf[4];
+  Counter::reset();
+  Bus::invalidate();
+  Bus::config_read();
+  Bus::config_read();
+  Bus::read_block(0x3FFE, buf, 4);
+  Bus::config_write();
+  Bus::write_bus(0x8000, 0);
+  // Repeated config_read is filtered by CachedDirectionBus
+  TEST_ASSERT_EQUAL(1, Counter::counts().config_reads);
+  TEST_ASSERT_EQUAL(1, Counter::counts().config_writes);
+  TEST_ASSERT_EQUAL(4, Counter::counts().reads);
+  TEST_ASSERT_EQUAL(1, Counter::counts().writes);
+  TEST_ASSERT_EQUAL(2, Counter::bin_count(0));
+  TEST_ASSERT_EQUAL(2, Counter::bin_count(1));
+  TEST_ASSERT_EQUAL(1, Counter::bin_count(2));
+}
+
+void test_bus_shadow() {
+  using Counter = core::io::CountingBus<BlockBus>;
+  using Bus = core::io::ShadowBus<Counter, 8, 2>;
+  block_data[5] = 0x55;
+  Bus::invalidate();
+  Counter::reset();
+  TEST_ASSERT_EQUAL(0x55, Bus::read_bus(5));
+  TEST_ASSERT_EQUAL(0x55, Bus::read_bus(5));
+  // Second read hits the cached line
+  TEST_ASSERT_EQUAL(8, Counter::counts().reads);
+  Bus::write_bus(5, 0x66);
+  TEST_ASSERT_EQUAL(0x66, Bus::read_bus(5));
+  // Line 16-23 maps to the same slot and evicts line 0-7
+  Bus::read_bus(16);
+  block_data[5] = 0x77;
+  TEST_ASSERT_EQUAL(0x77, Bus::read_bus(5));
+  block_data[5] = 0x88;
+  Bus::invalidate(4, 2);
+  TEST_ASSERT_EQUAL(0x88, Bus::read_bus(5));
+  TEST_ASSERT_EQUAL(32, Counter::counts().reads);
+}
+
+void test_bus_diff_write() {
+  using Counter = core::io::CountingBus<BlockBus>;
+  using Bus = core::io::DiffWriteBus<core::io::PageWriteBus<Counter, 8>, 4>;
+  const uint8_t image[6] = { 1, 2, 3, 4, 5, 6 };
+  for (uint8_t i = 0; i < 6; ++i) block_data[40 + i] = image[i];
+  block_data[42] = 0;
+  block_data[45] = 0;
+  Bus::reset();
+  Counter::reset();
+  Bus::config_write();
+  Bus::write_block(40, image, 6);
+  Bus::write_bus(40, 1);
+  Bus::flush_write();
+  TEST_ASSERT_EQUAL(2, Bus::written());
+  TEST_ASSERT_EQUAL(5, Bus::skipped());
+  TEST_ASSERT_EQUAL(3, block_data[42]);
+  TEST_ASSERT_EQUAL(6, block_data[45]);
+  // Only the changed words reach the device
+  TEST_ASSERT_EQUAL(2, Counter::counts().writes);
+  // Sequential write_bus calls are read back as one block, plus one poll
+  Counter::reset();
+  for (uint8_t i = 0; i < 4; ++i) Bus::write_bus(40 + i, i == 3 ? 0 : image[i]);
+  Bus::flush_write();
+  TEST_ASSERT_EQUAL(2, Counter::counts().config_reads);
+  TEST_ASSERT_EQUAL(1, Counter::counts().writes);
+  TEST_ASSERT_EQUAL(0, block_data[43]);
+}
+
+uint8_t sim_data[0x200];
+using SimBus = CORE_SIM_BUS_TIMED(sim_data, uint16_t, core::io::SimTimingEEPROM);
+
+void test_bus_sim() {
+  using T = core::io::SimTimingEEPROM;
+  uint8_t buf[0x20] = {};
+  SimBus::reset();
+  SimBus::read_block(0x1F0, buf, 0x20);
+  // Two address ports to seek, then one per increment plus one for the carry
+  TEST_ASSERT_EQUAL(T::CALL + 0x20 * T::READ + (2 + 0x1F + 1) * T::ADDRESS_PORT, SimBus::cycles());
+  SimBus::reset();
+  SimBus::write_bus(0, 1);
+  SimBus::write_bus(1, 2);
+  SimBus::flush_write();
+  // Loads to the same page within tBLC share one write cycle
+  TEST_ASSERT_EQUAL(2 * (T::CALL + T::WRITE + 2 * T::ADDRESS_PORT) + T::WRITE_CYCLE, SimBus::cycles());
+  TEST_ASSERT_EQUAL(2, sim_data[1]);
+  SimBus::reset();
+  uint8_t page[0x48] = {};
+  SimBus::write_block(0x1F0, page, 0x48);
+  SimBus::flush_write();
+  // Crossing from page $1C0 to $200 ends the first write cycle
+  TEST_ASSERT_EQUAL(2, SimBus::cycles() / T::WRITE_CYCLE);
+}
+
+void test_bus_sim_overflow() {
+  using T = core::io::SimTimingEEPROM;
+  constexpr uint32_t WRITES = 30000;
+  SimBus::reset();
+  for (uint32_t i = 0; i < WRITES; ++i) {
+    SimBus::write_bus(i, 0);
+    SimBus::flush_write();
+  }
+  // One write cycle per byte passes 2^32 cycles (about 268 s at 16 MHz)
+  const uint64_t expect = uint64_t(WRITES) * (T::CALL + T::WRITE + 2 * T::ADDRESS_PORT + T::WRITE_CYCLE);
+  TEST_ASSERT_TRUE(expect > 0xFFFFFFFF);
+  TEST_ASSERT_TRUE(expect == SimBus::cycles());
+  TEST_ASSERT_TRUE(expect / 16 == SimBus::micros());
+}
+
+void test_bus_sim_page_write() {
+  using T = core::io::SimTimingEEPROM;
+  using PageBus = core::io::PageWriteBus<SimBus, 64>;
+  // Fill with read back after each write, as when verifying or skipping unchanged words
+  SimBus::reset();
+  for (uint16_t i = 0; i < 0x80; ++i) {
+    SimBus::write_bus(i, 0xAA);
+    SimBus::read_bus(i);
+  }
+  SimBus::flush_write();
+  const uint32_t raw = SimBus::cycles();
+  // Each read ends the load, so every word costs a write cycle
+  TEST_ASSERT_TRUE(raw >= 0x80 * T::WRITE_CYCLE);
+  SimBus::reset();
+  for (uint16_t i = 0; i < 0x80; ++i) {
+    PageBus::write_bus(i, 0x55);
+    PageBus::read_bus(i);
+  }
+  PageBus::flush_write();
+  // Reads are served from the page buffer, so one write cycle per page
+  TEST_ASSERT_TRUE(SimBus::cycles() < 3 * T::WRITE_CYCLE);
+  TEST_ASSERT_TRUE(SimBus::cycles() < raw);
+  TEST_ASSERT_EQUAL(0x55, sim_data[0x7F]);
+}
+
+// Masked register that counts writes, with a LAYOUT like io::Port on AVR
+uint8_t fake_regs[2];
+uint8_t fake_reg_writes[2];
+
+template <uint8_t R, uint8_t M = 0xFF>
+struct FakeReg {
+  using TYPE = uint8_t;
+  static const TYPE MASK = M;
+  template <uint8_t SUBMASK>
+  using Mask = FakeReg<R, SUBMASK>;
+  using LAYOUT = core::io::Layout<core::io::Component<FakeReg<R>, TYPE, M, 0>>;
+  static void write(TYPE value) {
+    fake_regs[R] = (fake_regs[R] & ~M) | (value & M);
+    ++fake_reg_writes[R];
+  }
+  static TYPE read() { return fake_regs[R] & M; }
+};
+
+void test_port_grouping() {
+  // Bits 4:3 in reg 0, bit 2 in reg 1, bits 1:0 in reg 0
+  using Port = core::io::BitExtend<FakeReg<0, 0x30>, FakeReg<1, 0x80>, FakeReg<0, 0x03>>;
+  fake_regs[0] = fake_regs[1] = 0xFF;
+  fake_reg_writes[0] = fake_reg_writes[1] = 0;
+  Port::write(0x1A);
+  // Components in reg 0 are merged into a single write
+  TEST_ASSERT_EQUAL(1, fake_reg_writes[0]);
+  TEST_ASSERT_EQUAL(1, fake_reg_writes[1]);
+  TEST_ASSERT_EQUAL(0xFE, fake_regs[0]);
+  TEST_ASSERT_EQUAL(0x7F, fake_regs[1]);
+  TEST_ASSERT_EQUAL(0x1A, Port::read());
+}
+
+void test_port_word_shared() {
+  // High nibble of each byte in one register: value bits 15:12 and 3:0 in reg 0
+  using Port = core::io::WordExtend<FakeReg<0, 0xF0>, FakeReg<0, 0x0F>>;
+  TEST_ASSERT_EQUAL(0xF00F, Port::MASK);
+  fake_regs[0] = 0;
+  fake_reg_writes[0] = 0;
+  Port::write(0xA005);
+  // Both halves are merged into a single write
+  TEST_ASSERT_EQUAL(1, fake_reg_writes[0]);
+  TEST_ASSERT_EQUAL(0xA5, fake_regs[0]);
+  TEST_ASSERT_EQUAL(0xA005, Port::read());
+  core::io::write_changed<Port>(0xA005, 0xA005);
+  TEST_ASSERT_EQUAL(1, fake_reg_writes[0]);
+  core::io::write_changed<Port>(0xA005, 0x3005);
+  TEST_ASSERT_EQUAL(2, fake_reg_writes[0]);
+  TEST_ASSERT_EQUAL(0x35, fake_regs[0]);
+}
+
+void test_port_permute() {
+  // Value bits 0-3 wired to reg bits 6, 7, 0, 2
+  using Port = core::io::PermutePort<FakeReg<1>, 6, 7, 0, 2>;
+  TEST_ASSERT_EQUAL(0x0F, Port::MASK);
+  fake_regs[1] = 0;
+  Port::write(0x05);
+  TEST_ASSERT_EQUAL(0x41, fake_regs[1]);
+  TEST_ASSERT_EQUAL(0x05, Port::read());
+  for (uint16_t i = 0; i < 16; ++i) {
+    TEST_ASSERT_EQUAL(i, Port::from_port(Port::to_port(i)));
+  }
+  // Unmapped reg bits are preserved
+  using Part = core::io::PermutePort<FakeReg<1>, 5, 0, 3>;
+  fake_regs[1] = 0xFF;
+  Part::write(2);
+  TEST_ASSERT_EQUAL(0xD7, fake_regs[1]);
+  TEST_ASSERT_EQUAL(2, Part::read());
+}
+
+void test_bus_mmap() {
+  using Bus = core::io::MmapBus<uint16_t>;
+  char path[] = "/tmp/core_mmap_XXXXXX";
+  const int fd = mkstemp(path);
+  TEST_ASSERT_TRUE(fd >= 0);
+  const uint8_t image[4] = { 0x10, 0x20, 0x30, 0x40 };
+  TEST_ASSERT_EQUAL(4, write(fd, image, 4));
+  close(fd);
+
+  TEST_ASSERT_TRUE(Bus::open(path, core::io::MmapMode::READ_WRITE));
+  const uint8_t patch[3] = { 0xAA, 0xBB, 0xCC };
+  // Wraps from end of image back to start
+  Bus::write_block(3, patch, 3);
+  Bus::close();
+
+  TEST_ASSERT_TRUE(Bus::open(path));
+  uint8_t buf[6];
+  Bus::read_block(0, buf, 6);
+  const uint8_t expect[6] = { 0xBB, 0xCC, 0x30, 0xAA, 0xBB, 0xCC };
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expect, buf, 6);
+  // Writes ignored when read-only
+  Bus::write_bus(2, 0x00);
+  TEST_ASSERT_EQUAL(0x30, Bus::read_bus(2));
+  Bus::close();
+  TEST_ASSERT_EQUAL(0, Bus::read_bus(0));
+  unlink(path);
+}
+
+void test_crc() {
+  const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+  TEST_ASSERT_EQUAL(0x29B1, core::mon::crc16_update(core::mon::CRC16_INIT, check, 9));
+  TEST_ASSERT_EQUAL(0xCBF43926,
+    core::mon::crc32_update(core::mon::CRC32_INIT, check, 9) ^ core::mon::CRC32_INIT);
+
+  // Slicing-by-8 must agree with bytewise updates over a bus range
+  for (uint8_t i = 0; i < 64; ++i) block_data[i] = i * 37;
+  uint32_t crc = core::mon::CRC32_INIT;
+  core::mon::impl_read_bytes<BlockAPI, 20>(3, 50, [&crc](const uint8_t* bytes, uint16_t n) {
+    crc = core::mon::crc32_update(crc, bytes, n);
+  });
+  uint32_t expect = core::mon::CRC32_INIT;
+  for (uint8_t i = 3; i < 53; ++i) {
+    expect = core::mon::crc32_update(expect, &block_data[i], 1);
+  }
+  TEST_ASSERT_EQUAL(expect, crc);
+}
+
+void test_diff() {
+  for (uint8_t i = 0; i < 64; ++i) block_data[i] = i;
+  uint8_t expect[40];
+  for (uint8_t i = 0; i < 40; ++i) expect[i] = i;
+  expect[2] = expect[3] = expect[4] = 0xFF;
+  expect[39] = 0xFF;
+  auto load = [&expect](uint16_t offset, uint8_t* buf, uint8_t n) {
+    memcpy(buf, expect + offset, n);
+  };
+  // Runs span chunk boundaries and end of range
+  TEST_ASSERT_EQUAL(2, (core::mon::impl_diff<BlockAPI, 4>(0, 40, 16, load)));
+  TEST_ASSERT_EQUAL(1, (core::mon::impl_diff<BlockAPI, 4>(0, 40, 1, load)));
+  TEST_ASSERT_EQUAL(0, (core::mon::impl_diff<BlockAPI, 4>(5, 30, 16,
+    [&expect](uint16_t offset, uint8_t* buf, uint8_t n) { memcpy(buf, expect + 5 + offset, n); })));
+}
+
+void test_find() {
+  for (uint8_t i = 0; i < 64; ++i) block_data[i] = 'a';
+  memcpy(block_data + 10, "abab", 4);
+  memcpy(block_data + 60, "bab", 3);
+  const uint8_t pattern[] = { 'b', 'a', 'b' };
+  uint16_t found[4];
+  uint8_t count = 0;
+  // Small ring forces refills while matches overlap
+  core::mon::impl_find<BlockAPI, 8>(0, 64, pattern, 3, [&](uint16_t addr) {
+    if (count < 4) found[count] = addr;
+    ++count;
+  });
+  TEST_ASSERT_EQUAL(2, count);
+  TEST_ASSERT_EQUAL(11, found[0]);
+  TEST_ASSERT_EQUAL(60, found[1]);
+}
+
+// Bus with bit 2 stuck high at address 5
+struct StuckBus : BlockBus {
+  static DATA_TYPE read_bus(ADDRESS_TYPE addr) {
+    return BlockBus::read_bus(addr) | (addr == 5 ? 0x04 : 0);
+  }
+  static void read_block(ADDRESS_TYPE addr, DATA_TYPE* buf, uint16_t n) {
+    for (uint16_t i = 0; i < n; ++i) buf[i] = read_bus(addr + i);
+  }
+};
+
+struct StuckAPI : public core::mon::Base<StuckAPI> {
+  using BUS = StuckBus;
+};
+
+void test_mem_test() {
+  uint16_t fails = 0;
+  uint8_t bits = 0;
+  uint32_t bytes = core::mon::impl_test<StuckAPI>(0, 16, [&](uint16_t addr, uint8_t expect, uint8_t actual) {
+    if (actual != expect) {
+      TEST_ASSERT_EQUAL(5, addr);
+      ++fails;
+      bits |= actual ^ expect;
+    }
+  });
+  TEST_ASSERT_EQUAL(0x04, bits);
+  // Fails r0 in 3 march elements and 7 of 8 walking ones
+  TEST_ASSERT_EQUAL(10, fails);
+  TEST_ASSERT_EQUAL(16 * 26, bytes);
+}
+
+void test_mul_div_fraction() {
+  const uint32_t divisors[] = { 1, 3, 1000, 4294967, 4294968, 100000007, 0xFFFFFFFF };
+  for (uint32_t c : divisors) {
+    const uint32_t remainders[] = { 0, c / 3, c / 2, c - 1 };
+    for (uint32_t a : remainders) {
+      TEST_ASSERT_TRUE(uint64_t(a) * 1000 / c == core::mon::mul_div_fraction(a, 1000, c));
+    }
+  }
+}
+
+void test_hex_collapse() {
+  memset(block_data, 0, 64);
+  block_data[40] = 1;
+  // Row 0, *, row 40, then final row 44 forced by MAX_ROWS
+  TEST_ASSERT_EQUAL(48, (core::mon::impl_hex<BlockAPI, 4, 4>(0, 63)));
+  TEST_ASSERT_EQUAL(16, (core::mon::impl_hex<BlockAPI, 4, 4, false>(0, 63)));
+  // Identical final row is still printed
+  TEST_ASSERT_EQUAL(64, (core::mon::impl_hex<BlockAPI, 4, 4>(44, 63)));
+}
+
+// Output buffer large enough for a few lines of monitor output
+CursorOwner<255> mon_out;
+// Scripted input for monitor commands
+const char* mon_in = "";
+
+template <typename BUS_TYPE>
+struct IoAPI : public core::mon::Base<IoAPI<BUS_TYPE>> {
+  static void print_char(char c) { mon_out.try_insert(c); }
+  static void print_string(const char* str) { mon_out.try_insert(str); }
+  static void newline() { mon_out.try_insert('\n'); }
+
+  // Input ends with ESC once the script is consumed
+  static char input_char() { return *mon_in ? *mon_in++ : '\e'; }
+
+  static bool try_input_char(char& c) {
+    if (*mon_in == '\0') return false;
+    c = *mon_in++;
+    return true;
+  }
+
+  using BUS = BUS_TYPE;
+
+  static void prompt_char(char c) { }
+  static void prompt_string(const char* str) { }
+};
+
+// Run cmd with command line (starting with the command name) on input,
+// returning its output
+template <typename API>
+const char* run_cmd(void (*cmd)(Args), const char* input, const char* command = "") {
+  static char line[32];
+  strncpy(line, command, sizeof(line) - 1);
+  mon_in = input;
+  mon_out.clear();
+  cmd(Args(line));
+  return mon_out.contents();
+}
+
+uint8_t wide_data[0x20000];
+using WideAPI = IoAPI<core::io::ArrayBus<uint8_t, uint32_t, 0x20000, wide_data>>;
+using BlockIoAPI = IoAPI<BlockBus>;
+
+void test_ihx_linear() {
+  for (uint32_t i = 0; i < 0x20000; ++i) wide_data[i] = i * 7;
+  mon_out.clear();
+  core::mon::impl_export<WideAPI, 8>(0xFFF8, 16);
+  // Extended linear address record precedes data above 64K
+  TEST_ASSERT_TRUE(strstr(mon_out.contents(), ":020000040001F9\n:08000000") != nullptr);
+  char image[255];
+  strcpy(image, mon_out.contents());
+  memset(wide_data + 0xFFF0, 0, 0x20);
+  TEST_ASSERT_EQUAL_STRING("\nOK\n", run_cmd<WideAPI>(core::mon::cmd_import<WideAPI>, image));
+  for (uint32_t i = 0xFFF8; i < 0x10008; ++i) TEST_ASSERT_EQUAL(uint8_t(i * 7), wide_data[i]);
+  TEST_ASSERT_EQUAL(0, wide_data[0xFFF7]);
+  TEST_ASSERT_EQUAL(0, wide_data[0x10008]);
+}
+
+void test_ihx_segment() {
+  memset(wide_data + 0x10000, 0, 0x20);
+  // Segment $1000 sets base address $10000
+  TEST_ASSERT_EQUAL_STRING("\nOK\n", run_cmd<WideAPI>(core::mon::cmd_import<WideAPI>,
+    ":020000021000EC\n:04001000AABBCCDDDE\n:00000001FF\n"));
+  const uint8_t expect[4] = { 0xAA, 0xBB, 0xCC, 0xDD };
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expect, wide_data + 0x10010, 4);
+  TEST_ASSERT_EQUAL(0x70, wide_data[0x10]);
+
+  // Data above a 16-bit bus is rejected instead of wrapping to $0010
+  for (uint8_t i = 0; i < 64; ++i) block_data[i] = 0;
+  const char* image = ":020000021000EC\n:04001000AABBCCDDDE\n:00000001FF\n";
+  TEST_ASSERT_EQUAL_STRING("\naddr?\nERROR\n", run_cmd<BlockIoAPI>(core::mon::cmd_import<BlockIoAPI>, image));
+  TEST_ASSERT_EQUAL(0, block_data[0x10]);
+  TEST_ASSERT_EQUAL_STRING("\naddr?\nERROR\n", run_cmd<BlockIoAPI>(core::mon::cmd_verify<BlockIoAPI>, image));
+}
+
+// API with blocking input only, as before try_input_char was added
+struct EchoAPI : public core::mon::Base<EchoAPI> {
+  static void print_char(char c) { mon_out.try_insert(c); }
+  static void print_string(const char* str) { mon_out.try_insert(str); }
+  static void newline() { mon_out.try_insert('\n'); }
+  static char input_char() { return *mon_in ? *mon_in++ : '\e'; }
+
+  using BUS = BlockBus;
+
+  static void prompt_char(char c) { }
+  static void prompt_string(const char* str) { }
+};
+
+void test_ihx_echo_api() {
+  block_data[0] = 0xAA;
+  TEST_ASSERT_EQUAL_STRING("\nPASS\n", run_cmd<EchoAPI>(core::mon::cmd_verify<EchoAPI>,
+    ":01000000AA55\n:00000001FF\n"));
+}
+
+uint16_t word_data[32];
+using WordAPI = IoAPI<CORE_ARRAY_BUS(word_data, uint16_t)>;
+
+void test_ihx_lanes() {
+  for (uint16_t i = 0; i < 32; ++i) word_data[i] = 0x4100 + i;
+  mon_out.clear();
+  core::mon::impl_export<WordAPI, 8>(4, 6);
+  // Word 4 is at byte address 8, low byte first
+  TEST_ASSERT_TRUE(strncmp(mon_out.contents(), ":080008000441054106410741", 25) == 0);
+  char image[255];
+  strcpy(image, mon_out.contents());
+  TEST_ASSERT_EQUAL_STRING("\nPASS\n", run_cmd<WordAPI>(core::mon::cmd_verify<WordAPI>, image));
+  memset(word_data, 0, sizeof(word_data));
+  TEST_ASSERT_EQUAL_STRING("\nOK\n", run_cmd<WordAPI>(core::mon::cmd_import<WordAPI>, image));
+  for (uint16_t i = 4; i < 10; ++i) TEST_ASSERT_EQUAL(0x4100 + i, word_data[i]);
+  TEST_ASSERT_EQUAL(0, word_data[10]);
+  // Mismatch in the high byte of one word
+  word_data[6] = 0x4206;
+  TEST_ASSERT_EQUAL_STRING("*\nFAIL\n", run_cmd<WordAPI>(core::mon::cmd_verify<WordAPI>, image));
+}
+
+void test_ihx_partial_word() {
+  word_data[0x10] = 0x1234;
+  word_data[0x11] = 0x5678;
+  // High byte of word $10, then low byte of word $11
+  TEST_ASSERT_EQUAL_STRING("\nOK\n", run_cmd<WordAPI>(core::mon::cmd_import<WordAPI>,
+    ":01002100AB33\n:01002200CD10\n:00000001FF\n"));
+  TEST_ASSERT_EQUAL(0xAB34, word_data[0x10]);
+  TEST_ASSERT_EQUAL(0x56CD, word_data[0x11]);
+}
+
+void test_sync() {
+  for (uint8_t i = 0; i < 64; ++i) block_data[i] = i;
+  const uint32_t crc = core::mon::crc32_update(core::mon::CRC32_INIT, block_data, 16) ^ core::mon::CRC32_INIT;
+  char input[32];
+  // Host image matches the first block; second block has one changed byte
+  snprintf(input, sizeof(input), "$%08X\n$%08X\n", unsigned(crc), unsigned(crc));
+  for (uint8_t i = 0; i < 16; ++i) block_data[16 + i] = i;
+  block_data[20] = 0xFF;
+  // Hashes are not echoed; only the reply for each block is printed
+  TEST_ASSERT_EQUAL_STRING("=*\ndiffer $0001\n",
+    run_cmd<BlockIoAPI>(core::mon::cmd_sync<BlockIoAPI>, input, "sync 0 $20 $10"));
+}
+
+void test_diff_truncated() {
+  for (uint8_t i = 0; i < 64; ++i) block_data[i] = i % 32;
+  block_data[32 + 2] = block_data[32 + 9] = 0xFF;
+  // Second run is omitted
+  TEST_ASSERT_EQUAL_STRING("$0002-$0002 differ\n...\n",
+    run_cmd<BlockIoAPI>(core::mon::cmd_compare<BlockIoAPI>, "", "compare 0 $10 $20 1"));
+  // No marker when the last run fits
+  TEST_ASSERT_EQUAL_STRING("$0002-$0002 differ\n$0009-$0009 differ\n",
+    run_cmd<BlockIoAPI>(core::mon::cmd_compare<BlockIoAPI>, "", "compare 0 $10 $20 2"));
+  // Zero runs can't be told apart from no difference
+  TEST_ASSERT_EQUAL_STRING("max_runs?\n",
+    run_cmd<BlockIoAPI>(core::mon::cmd_compare<BlockIoAPI>, "", "compare 0 $10 $20 0"));
+}
+
+void test_snap_delta() {
+  TEST_ASSERT_EQUAL_STRING("snap?\n",
+    run_cmd<BlockIoAPI>(core::mon::cmd_delta<BlockIoAPI>, "", "delta"));
+  TEST_ASSERT_EQUAL_STRING("max_runs?\n",
+    run_cmd<BlockIoAPI>(core::mon::cmd_delta<BlockIoAPI>, "", "delta 0"));
+  for (uint8_t i = 0; i < 64; ++i) block_data[i] = i;
+  run_cmd<BlockIoAPI>(core::mon::cmd_snap<BlockIoAPI>, "", "snap 8 $20");
+  TEST_ASSERT_EQUAL_STRING("same\n",
+    run_cmd<BlockIoAPI>(core::mon::cmd_delta<BlockIoAPI>, "", "delta"));
+  // Two separate runs, plus a change outside the snapshot
+  block_data[10] = block_data[11] = 0xFF;
+  block_data[20] = 0xFF;
+  block_data[40] = 0xFF;
+  TEST_ASSERT_EQUAL_STRING("$000A-$000B differ\n$0014-$0014 differ\n",
+    run_cmd<BlockIoAPI>(core::mon::cmd_delta<BlockIoAPI>, "", "delta"));
+}
+
+// Screen for cmd_watch, with cursor movement
+char screen[4][160];
+uint8_t screen_row, screen_col, saved_row, saved_col;
+uint16_t screen_prints;
+uint8_t watch_polls;
+void (*watch_edit)();
+
+template <typename BUS_TYPE>
+struct ScreenAPI : public core::mon::Base<ScreenAPI<BUS_TYPE>> {
+  static void print_char(char c) {
+    screen[screen_row][screen_col++] = c;
+    ++screen_prints;
+  }
+  static void print_string(const char* str) { while (*str) print_char(*str++); }
+  static void newline() { ++screen_row; screen_col = 0; }
+  static void save_cursor() { saved_row = screen_row; saved_col = screen_col; }
+  static void restore_cursor() { screen_row = saved_row; screen_col = saved_col; }
+  static void cursor_up(uint8_t spaces) { screen_row -= spaces; }
+  static void cursor_right(uint8_t spaces) { screen_col += spaces; }
+
+  // Edit memory after the first frame is printed, then quit after one redraw
+  static bool try_input_char(char& c) {
+    if (watch_polls++ == 0) {
+      watch_edit();
+      screen_prints = 0;
+      return false;
+    }
+    c = ' ';
+    return true;
+  }
+
+  using BUS = BUS_TYPE;
+
+  static void prompt_char(char c) { }
+  static void prompt_string(const char* str) { }
+};
+
+void clear_screen() {
+  memset(screen, ' ', sizeof(screen));
+  screen_row = screen_col = 0;
+  screen_prints = 0;
+  watch_polls = 0;
+}
+
+// Watch 2 rows at start, then check the redrawn screen matches a fresh dump
+template <typename API>
+void check_watch(const char* command, typename API::BUS::ADDRESS_TYPE start) {
+  using DATA = typename API::BUS::DATA_TYPE;
+  char line[32];
+  strcpy(line, command);
+  clear_screen();
+  core::mon::cmd_watch<API>(Args(line));
+  char live[sizeof(screen)];
+  memcpy(live, screen, sizeof(screen));
+  // Hex and ASCII cells of the 2 changed words are rewritten in place
+  TEST_ASSERT_EQUAL(2 * 3 * sizeof(DATA), screen_prints);
+  clear_screen();
+  for (uint8_t row = 0; row < 2; ++row) {
+    DATA row_data[16];
+    core::io::read_block<typename API::BUS>(start + row * 16, row_data, 16);
+    core::mon::print_hex_row<API, 16>(start + row * 16, row_data);
+  }
+  TEST_ASSERT_TRUE(memcmp(live, screen, sizeof(screen)) == 0);
+}
+
+void test_watch() {
+  using ByteScreen = ScreenAPI<BlockBus>;
+  for (uint8_t i = 0; i < 64; ++i) block_data[i] = 0x40 + i;
+  // First and last cells test the hex column and ASCII_START math
+  watch_edit = []() { block_data[0x10] = 0x7A; block_data[0x2F] = 0x21; };
+  check_watch<ByteScreen>("watch $10 $20 0", 0x10);
+
+  using WordScreen = ScreenAPI<CORE_ARRAY_BUS(word_data, uint16_t)>;
+  for (uint16_t i = 0; i < 32; ++i) word_data[i] = 0x4120 + i;
+  watch_edit = []() { word_data[0x00] = 0x7A; word_data[0x13] = 0x4142; };
+  check_watch<WordScreen>("watch 0 $20 0", 0);
+
+  // Ranges over MAX_ROWS rows are refused
+  char line[] = "watch 0 $101";
+  clear_screen();
+  core::mon::cmd_watch<ByteScreen>(Args(line));
+  TEST_ASSERT_TRUE(strncmp(screen[0], "size?", 5) == 0);
+  TEST_ASSERT_EQUAL(1, screen_row);
+}
+
+// Input polled by stream_ready, where '.' is a poll with no input
+const char* stream_in = "";
+int stream_free = 0;
+
+struct StreamAPI : IoAPI<BlockBus> {
+  static bool try_input_char(char& c) {
+    if (*stream_in == '\0') return false;
+    c = *stream_in++;
+    return c != '.';
+  }
+
+  static int available_for_write() { return stream_free; }
+};
+
+void test_stream_ready() {
+  // Unknown free space (Arduino default of 0) must not block
+  stream_in = "";
+  stream_free = 0;
+  TEST_ASSERT_TRUE(core::mon::stream_ready<StreamAPI>());
+  // Paused from XOFF until XON, polling meanwhile
+  stream_in = "\x13...\x11";
+  stream_free = 64;
+  TEST_ASSERT_TRUE(core::mon::stream_ready<StreamAPI>());
+  TEST_ASSERT_EQUAL('\0', *stream_in);
+  // Escape while paused
+  stream_in = "\x13..\e.";
+  TEST_ASSERT_FALSE(core::mon::stream_ready<StreamAPI>());
+  TEST_ASSERT_EQUAL_STRING(".", stream_in);
+
+  // Escape stops streamed hex dump after 2 rows
+  memset(block_data, 0, 64);
+  stream_in = "..\e";
+  char line[] = "hex 0 $40";
+  mon_out.clear();
+  core::mon::cmd_hex<StreamAPI, 8, 0, false>(Args(line));
+  const char* out = mon_out.contents();
+  TEST_ASSERT_TRUE(strstr(out, " 0008 ") != nullptr);
+  TEST_ASSERT_TRUE(strstr(out, " 0010 ") == nullptr);
+}
+
+using DiffAPI = IoAPI<core::io::DiffWriteBus<BlockBus, 4>>;
+
+void test_diff_write_stats() {
+  memset(block_data, 0, 64);
+  TEST_ASSERT_EQUAL_STRING("written $00000006 skipped $00000000\n",
+    run_cmd<DiffAPI>(core::mon::cmd_fill<DiffAPI>, "", "fill 2 6 $AA"));
+  // Counts restart with each command
+  TEST_ASSERT_EQUAL_STRING("written $00000002 skipped $00000006\n",
+    run_cmd<DiffAPI>(core::mon::cmd_fill<DiffAPI>, "", "fill 0 8 $AA"));
+  TEST_ASSERT_EQUAL_STRING("\nwritten $00000001 skipped $00000001\nOK\n",
+    run_cmd<DiffAPI>(core::mon::cmd_import<DiffAPI>, ":02000000AA0153\n:00000001FF\n"));
+  TEST_ASSERT_EQUAL(0x01, block_data[1]);
+}
+
 int main(int argc, char* argv[]) {
   UNITY_BEGIN();
   RUN_TEST(test_str_sort);
@@ -346,5 +1233,42 @@ int main(int argc, char* argv[]) {
   RUN_TEST(test_asm_ld_r);
   RUN_TEST(test_asm_alu_r);
   RUN_TEST(test_asm_inc_r);
+  RUN_TEST(test_bus_block);
+  RUN_TEST(test_bus_page_write);
+  RUN_TEST(test_bus_page_write_fail);
+  RUN_TEST(test_memmove);
+  RUN_TEST(test_bus_sequential);
+  RUN_TEST(test_bus_derived);
+  RUN_TEST(test_bus_mux);
+  RUN_TEST(test_latch_bank);
+  RUN_TEST(test_bus_banked);
+  RUN_TEST(test_bus_cached_direction);
+  RUN_TEST(test_bus_counting);
+  RUN_TEST(test_bus_shadow);
+  RUN_TEST(test_bus_diff_write);
+  RUN_TEST(test_bus_sim);
+  RUN_TEST(test_bus_sim_overflow);
+  RUN_TEST(test_bus_sim_page_write);
+  RUN_TEST(test_port_grouping);
+  RUN_TEST(test_port_word_shared);
+  RUN_TEST(test_port_permute);
+  RUN_TEST(test_bus_mmap);
+  RUN_TEST(test_crc);
+  RUN_TEST(test_diff);
+  RUN_TEST(test_find);
+  RUN_TEST(test_mem_test);
+  RUN_TEST(test_mul_div_fraction);
+  RUN_TEST(test_hex_collapse);
+  RUN_TEST(test_ihx_linear);
+  RUN_TEST(test_ihx_segment);
+  RUN_TEST(test_ihx_echo_api);
+  RUN_TEST(test_ihx_lanes);
+  RUN_TEST(test_ihx_partial_word);
+  RUN_TEST(test_sync);
+  RUN_TEST(test_diff_truncated);
+  RUN_TEST(test_snap_delta);
+  RUN_TEST(test_watch);
+  RUN_TEST(test_stream_ready);
+  RUN_TEST(test_diff_write_stats);
   UNITY_END();
 }